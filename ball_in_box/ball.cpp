@@ -0,0 +1,113 @@
+#include "ball.hpp"
+#include "../common/parallel.hpp"
+
+// elastic ball-ball collision for the time stepped engine
+// mass is taken proportional to the area of the ball
+// balls are pushed apart along the line of centres and the normal components of the velocity are exchanged
+void resolveBallCollision(Ball &a, Ball &b)
+{
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float sigma = a.radius + b.radius;
+    float distSq = dx * dx + dy * dy;
+    if (distSq >= sigma * sigma || distSq == 0.0f)
+        return;
+
+    float dist = std::sqrt(distSq);
+    float nx = dx / dist;
+    float ny = dy / dist;
+    float ma = a.radius * a.radius;
+    float mb = b.radius * b.radius;
+
+    // separate the overlap, shared by mass
+    float overlap = sigma - dist;
+    a.x -= nx * overlap * mb / (ma + mb);
+    a.y -= ny * overlap * mb / (ma + mb);
+    b.x += nx * overlap * ma / (ma + mb);
+    b.y += ny * overlap * ma / (ma + mb);
+
+    float vn = (b.vx - a.vx) * nx + (b.vy - a.vy) * ny;
+    if (vn >= 0.0f)
+        return; // already separating
+
+    float j = 2.0f * vn / (ma + mb);
+    a.vx += j * mb * nx;
+    a.vy += j * mb * ny;
+    b.vx -= j * ma * nx;
+    b.vy -= j * ma * ny;
+}
+
+// one fixed step of the time stepped engine: Ball::update for the walls, then a uniform grid broad phase for ball-ball overlaps
+// cells are at least one ball diameter wide so only the 3x3 neighbourhood has to be checked
+void stepBalls(std::vector<Ball> &balls, float dt, const Box &boxBounds)
+{
+    for (auto &ball : balls)
+        ball.update(dt, boxBounds);
+
+    float maxRadius = 0.0f;
+    for (const auto &ball : balls)
+        maxRadius = std::max(maxRadius, ball.radius);
+    if (balls.size() < 2 || maxRadius <= 0.0f)
+        return;
+
+    float cellSize = 2.0f * maxRadius;
+    int gridW = std::max(1, static_cast<int>(std::ceil(boxBounds.width / cellSize)));
+    int gridH = std::max(1, static_cast<int>(std::ceil(boxBounds.height / cellSize)));
+
+    // counting sort of the balls into cells
+    std::vector<int> cellOf(balls.size());
+    std::vector<int> cellStart(gridW * gridH + 1, 0);
+    std::vector<int> sorted(balls.size());
+    for (size_t i = 0; i < balls.size(); ++i)
+    {
+        int cx = std::clamp(static_cast<int>((balls[i].x - boxBounds.left) / cellSize), 0, gridW - 1);
+        int cy = std::clamp(static_cast<int>((balls[i].y - boxBounds.top) / cellSize), 0, gridH - 1);
+        cellOf[i] = cy * gridW + cx;
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (int c = 0; c < gridW * gridH; ++c)
+        cellStart[c + 1] += cellStart[c];
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < balls.size(); ++i)
+        sorted[fill[cellOf[i]]++] = static_cast<int>(i);
+
+    for (size_t i = 0; i < balls.size(); ++i)
+    {
+        int cx = cellOf[i] % gridW;
+        int cy = cellOf[i] / gridW;
+        for (int ny = std::max(0, cy - 1); ny <= std::min(gridH - 1, cy + 1); ++ny)
+        {
+            for (int nx = std::max(0, cx - 1); nx <= std::min(gridW - 1, cx + 1); ++nx)
+            {
+                int c = ny * gridW + nx;
+                for (int k = cellStart[c]; k < cellStart[c + 1]; ++k)
+                {
+                    // each pair once
+                    if (sorted[k] > static_cast<int>(i))
+                        resolveBallCollision(balls[i], balls[sorted[k]]);
+                }
+            }
+        }
+    }
+}
+
+void saveBalls(SnapshotWriter &writer, const std::vector<Ball> &balls)
+{
+    writer.array("balls", balls);
+}
+
+bool loadBalls(SnapshotReader &reader, std::vector<Ball> &balls)
+{
+    return reader.array("balls", balls);
+}
+
+void publishBalls(FrameRingWriter &ring, long long step, const std::vector<Ball> &balls, int threadCount)
+{
+    int count = static_cast<int>(balls.size());
+    ring.publish(step, balls.size(), [&](Vec2 *positions)
+                 { parallelFor(count, threadCount, CHEAP_LOOP_GRAIN, [&](int begin, int end)
+                               {
+                                   for (int i = begin; i < end; ++i)
+                                       positions[i] = Vec2(balls[i].x, balls[i].y);
+                               }); });
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../common/frame_ring.hpp"
+#include "../common/snapshot.hpp"
+#include "../common/vec2.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// time stepped balls in a box, no SFML in here so it can be used by the viewer, the headless runner and the benchmarks
+
+class Ball
+{
+public:
+    float x, y;
+    float vx, vy;
+    float ax, ay;
+    float radius;
+    float restitution; // coefficient of restitution between the ball and the wall
+
+    Ball(float x, float y, float radius, float vx, float vy, float ax = 0, float ay = 0, float restitution = 1.0f) : x(x), y(y), vx(vx), vy(vy), ax(ax), ay(ay), radius(radius), restitution(restitution) {}
+
+    void update(float dt, const Box &boxBounds)
+    {
+        Vec2 position(x, y);
+
+        vx += ax * dt;
+        vy += ay * dt;
+
+        position.x += vx * dt;
+        position.y += vy * dt;
+
+        // collision with left wall
+        if (position.x - radius < boxBounds.left)
+        {
+            position.x = boxBounds.left + radius;
+            vx = -vx * restitution;
+        }
+        // collision with right wall
+        else if (position.x + radius > boxBounds.left + boxBounds.width)
+        {
+            position.x = boxBounds.left + boxBounds.width - radius;
+            vx = -vx * restitution;
+        }
+        // collision with top wall
+        if (position.y - radius < boxBounds.top)
+        {
+            position.y = boxBounds.top + radius;
+            vy = -vy * restitution;
+        }
+        // collision with bottom wall
+        else if (position.y + radius > boxBounds.top + boxBounds.height)
+        {
+            position.y = boxBounds.top + boxBounds.height - radius;
+            vy = -vy * restitution;
+        }
+        x = position.x;
+        y = position.y;
+    }
+};
+
+
+// elastic ball-ball collision for the time stepped engine
+// mass is taken proportional to the area of the ball
+void resolveBallCollision(Ball &a, Ball &b);
+
+// one fixed step of the time stepped engine: Ball::update for the walls, then a uniform grid broad phase for ball-ball overlaps
+void stepBalls(std::vector<Ball> &balls, float dt, const Box &boxBounds);
+
+// the whole state of the time stepped engine is the balls themselves
+void saveBalls(SnapshotWriter &writer, const std::vector<Ball> &balls);
+bool loadBalls(SnapshotReader &reader, std::vector<Ball> &balls);
+
+// the centres of the balls as one frame of the ring (see frame_ring.hpp)
+void publishBalls(FrameRingWriter &ring, long long step, const std::vector<Ball> &balls, int threadCount = 1);
+
+// random non-overlapping balls for the event driven demo and the benchmark
+// placed on a jittered lattice so that setup is O(n)
+template <typename AddBall>
+void scatterBalls(const Box &boxBounds, int count, float radius, float speed, unsigned seed, AddBall &&addBall)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    float spacing = std::sqrt(boxBounds.width * boxBounds.height / count);
+    int cols = std::max(1, static_cast<int>(boxBounds.width / spacing));
+    int rows = (count + cols - 1) / cols;
+    float cellW = boxBounds.width / cols;
+    float cellH = boxBounds.height / rows;
+    float jitterX = std::max(0.0f, cellW - 2.0f * radius);
+    float jitterY = std::max(0.0f, cellH - 2.0f * radius);
+
+    for (int i = 0; i < count; ++i)
+    {
+        float x = boxBounds.left + (i % cols) * cellW + radius + unit(rng) * jitterX;
+        float y = boxBounds.top + (i / cols) * cellH + radius + unit(rng) * jitterY;
+        float angle = unit(rng) * 2.0f * static_cast<float>(M_PI);
+        addBall(x, y, radius, speed * std::cos(angle), speed * std::sin(angle));
+    }
+}
@@ -0,0 +1,46 @@
+#include "barnes_hut.hpp"
+
+#include <random>
+
+// O(n^2) reference, only for the bodies in [begin, end)
+void directAccelerations(const std::vector<float> &x, const std::vector<float> &y, const std::vector<float> &mass,
+                         float gravity, float softening, int begin, int end, std::vector<float> &ax, std::vector<float> &ay)
+{
+    const float epsSq = softening * softening;
+    for (int i = begin; i < end; ++i)
+    {
+        // accumulate in double so the reference is not limited by float round off over 10^6 terms
+        double sumX = 0.0, sumY = 0.0;
+        for (size_t j = 0; j < x.size(); ++j)
+        {
+            if (static_cast<int>(j) == i)
+                continue;
+            float dx = x[j] - x[i];
+            float dy = y[j] - y[i];
+            float r2 = dx * dx + dy * dy + epsSq;
+            float inv = 1.0f / (r2 * std::sqrt(r2));
+            sumX += mass[j] * dx * inv;
+            sumY += mass[j] * dy * inv;
+        }
+        ax[i] = static_cast<float>(gravity * sumX);
+        ay[i] = static_cast<float>(gravity * sumY);
+    }
+}
+
+// a disc of bodies, denser in the middle
+void makeDisc(int count, float centerX, float centerY, float radius, unsigned seed,
+              std::vector<float> &x, std::vector<float> &y, std::vector<float> &mass)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    x.resize(count);
+    y.resize(count);
+    mass.assign(count, 1.0f);
+    for (int i = 0; i < count; ++i)
+    {
+        float r = radius * unit(rng) * unit(rng);
+        float angle = unit(rng) * 2.0f * static_cast<float>(M_PI);
+        x[i] = centerX + r * std::cos(angle);
+        y[i] = centerY + r * std::sin(angle);
+    }
+}
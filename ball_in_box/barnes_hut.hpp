@@ -0,0 +1,254 @@
+#pragma once
+
+#include "../common/parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Barnes-Hut long range forces between the balls (gravity, or like charges with a negative constant)
+// the direct sum is O(n^2); instead, bodies are put in a quadtree and a far away cell is treated as a single body
+// at its centre of mass whenever cellSize / distance < theta (the opening angle), which makes it O(n log n).
+// theta is read in build(), the opening radius of every cell is precomputed there
+//
+// all nodes live in one pooled vector that is reused between frames, the four children of a node are allocated
+// together so a node only stores the index of its first child.
+// every node also stores "next", the node to continue with when its subtree is skipped, so the force walk
+// is a flat loop over the array with no recursion or stack
+//
+// reference: Barnes & Hut, "A hierarchical O(N log N) force-calculation algorithm" (Nature, 1986)
+
+struct QuadNode
+{
+    float centerX, centerY, halfSize;
+    float mass;
+    float comX, comY; // centre of mass
+    float openRadius; // bodies closer than this to the centre of mass open the cell
+    int firstChild;   // -1 for a leaf
+    int body;         // first body in a leaf, -1 if empty, the rest of a lumped leaf follow through sameLeaf
+    int next;         // node after this subtree, -1 at the end
+};
+
+class BarnesHutTree
+{
+public:
+    float theta = 0.5f;
+    float gravity = 1.0f;
+    float softening = 1.0f; // avoids the singularity when two bodies get very close
+
+    // bodies in the order they appear in the tree, threads walk this so neighbouring bodies share cache lines of the tree
+    std::vector<int> order;
+
+    void build(const std::vector<float> &x, const std::vector<float> &y, const std::vector<float> &mass)
+    {
+        nodes.clear();
+        order.clear();
+        sameLeaf.assign(x.size(), -1);
+        if (x.empty())
+            return;
+
+        float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+        for (size_t i = 1; i < x.size(); ++i)
+        {
+            minX = std::min(minX, x[i]);
+            maxX = std::max(maxX, x[i]);
+            minY = std::min(minY, y[i]);
+            maxY = std::max(maxY, y[i]);
+        }
+        float halfSize = 0.5f * std::max(maxX - minX, maxY - minY) * 1.0001f + 1e-3f;
+        nodes.reserve(2 * x.size());
+        nodes.push_back({0.5f * (minX + maxX), 0.5f * (minY + maxY), halfSize, 0, 0, 0, 0, -1, -1, -1});
+
+        // inserting in Morton (z-curve) order means consecutive inserts walk down nearly the same path,
+        // which keeps the build in cache instead of jumping around the tree
+        float scale = 65535.0f / (2.0f * halfSize);
+        float originX = nodes[0].centerX - halfSize;
+        float originY = nodes[0].centerY - halfSize;
+        std::vector<std::pair<uint32_t, int>> keys(x.size());
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            uint32_t cx = static_cast<uint32_t>((x[i] - originX) * scale);
+            uint32_t cy = static_cast<uint32_t>((y[i] - originY) * scale);
+            keys[i] = {spreadBits(cx) | (spreadBits(cy) << 1), static_cast<int>(i)};
+        }
+        std::sort(keys.begin(), keys.end());
+        for (const auto &key : keys)
+            insert(key.second, x, y);
+
+        summarize(0, -1, x, y, mass);
+    }
+
+    // a_i = G * sum_j m_j (r_j - r_i) / (|r_j - r_i|^2 + eps^2)^(3/2)
+    void computeAccelerations(const std::vector<float> &x, const std::vector<float> &y,
+                              std::vector<float> &ax, std::vector<float> &ay, int threadCount) const
+    {
+        ax.resize(x.size());
+        ay.resize(x.size());
+        if (nodes.empty())
+            return;
+
+        parallelFor(static_cast<int>(order.size()), threadCount, [&](int begin, int end)
+                    {
+                        for (int k = begin; k < end; ++k)
+                        {
+                            int i = order[k];
+                            accelerationAt(i, x[i], y[i], ax[i], ay[i]);
+                        }
+                    });
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+private:
+    std::vector<QuadNode> nodes;
+    std::vector<int> sameLeaf; // next body lumped into the same leaf, -1 at the end of the leaf
+    static constexpr int MAX_DEPTH = 32; // bodies closer than this resolves get lumped into one leaf
+
+    // interleaves the low 16 bits of v with zeros
+    static uint32_t spreadBits(uint32_t v)
+    {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    int quadrant(const QuadNode &node, float px, float py) const
+    {
+        return (px >= node.centerX ? 1 : 0) + (py >= node.centerY ? 2 : 0);
+    }
+
+    void split(int n)
+    {
+        int first = static_cast<int>(nodes.size());
+        float h = nodes[n].halfSize * 0.5f;
+        float cx = nodes[n].centerX;
+        float cy = nodes[n].centerY;
+        // push_back may reallocate, so nodes[n] is only touched again by index
+        for (int q = 0; q < 4; ++q)
+            nodes.push_back({cx + ((q & 1) ? h : -h), cy + ((q & 2) ? h : -h), h, 0, 0, 0, 0, -1, -1, -1});
+        nodes[n].firstChild = first;
+    }
+
+    void insert(int i, const std::vector<float> &x, const std::vector<float> &y)
+    {
+        int n = 0;
+        int depth = 0; // levels below the root, a split does not move the body down by itself
+        for (;;)
+        {
+            if (nodes[n].firstChild >= 0)
+            {
+                n = nodes[n].firstChild + quadrant(nodes[n], x[i], y[i]);
+                ++depth;
+                continue;
+            }
+            if (nodes[n].body < 0)
+            {
+                nodes[n].body = i;
+                return;
+            }
+            if (depth >= MAX_DEPTH)
+            {
+                // coincident bodies share the leaf, chained behind its first body. summarize() adds up their masses
+                // and puts every one of them in the order, so they all get an acceleration
+                sameLeaf[i] = sameLeaf[nodes[n].body];
+                sameLeaf[nodes[n].body] = i;
+                return;
+            }
+            // occupied leaf: push the resident body down one level and try again
+            int resident = nodes[n].body;
+            nodes[n].body = -1;
+            split(n);
+            int child = nodes[n].firstChild + quadrant(nodes[n], x[resident], y[resident]);
+            nodes[child].body = resident;
+        }
+    }
+
+    // bottom up mass and centre of mass, plus the skip pointers and the body order
+    void summarize(int n, int next, const std::vector<float> &x, const std::vector<float> &y, const std::vector<float> &mass)
+    {
+        QuadNode &node = nodes[n];
+        node.next = next;
+        if (node.firstChild < 0)
+        {
+            float m = 0.0f, mx = 0.0f, my = 0.0f;
+            for (int b = node.body; b >= 0; b = sameLeaf[b])
+            {
+                m += mass[b];
+                mx += mass[b] * x[b];
+                my += mass[b] * y[b];
+                order.push_back(b);
+            }
+            node.mass = m;
+            node.comX = m > 0.0f ? mx / m : node.centerX;
+            node.comY = m > 0.0f ? my / m : node.centerY;
+            return;
+        }
+
+        float m = 0.0f, mx = 0.0f, my = 0.0f;
+        int first = node.firstChild;
+        for (int q = 0; q < 4; ++q)
+        {
+            summarize(first + q, q < 3 ? first + q + 1 : next, x, y, mass);
+            const QuadNode &child = nodes[first + q];
+            m += child.mass;
+            mx += child.mass * child.comX;
+            my += child.mass * child.comY;
+        }
+        nodes[n].mass = m;
+        nodes[n].comX = m > 0.0f ? mx / m : nodes[n].centerX;
+        nodes[n].comY = m > 0.0f ? my / m : nodes[n].centerY;
+
+        // plain size / distance < theta measured from the centre of mass can accept a cell for a body that sits inside it
+        // when the mass is bunched up in one corner, so the radius is grown by the centre of mass offset (Salmon & Warren)
+        float offset = std::hypot(nodes[n].comX - nodes[n].centerX, nodes[n].comY - nodes[n].centerY);
+        nodes[n].openRadius = 2.0f * nodes[n].halfSize / std::max(theta, 1e-6f) + offset;
+    }
+
+    void accelerationAt(int i, float px, float py, float &outX, float &outY) const
+    {
+        const float epsSq = softening * softening;
+        float sumX = 0.0f, sumY = 0.0f;
+
+        int n = 0;
+        while (n >= 0)
+        {
+            const QuadNode &node = nodes[n];
+            // skips the body's own leaf. the other bodies of a lumped leaf sit on its centre of mass, the leaf pulls them with ~0
+            if (node.mass == 0.0f || node.body == i)
+            {
+                n = node.next;
+                continue;
+            }
+            float dx = node.comX - px;
+            float dy = node.comY - py;
+            float distSq = dx * dx + dy * dy;
+
+            if (node.firstChild < 0 || node.openRadius * node.openRadius < distSq)
+            {
+                float r2 = distSq + epsSq;
+                float inv = 1.0f / (r2 * std::sqrt(r2));
+                sumX += node.mass * dx * inv;
+                sumY += node.mass * dy * inv;
+                n = node.next;
+            }
+            else
+            {
+                n = node.firstChild; // open the cell
+            }
+        }
+        outX = gravity * sumX;
+        outY = gravity * sumY;
+    }
+};
+
+// O(n^2) reference, only for the bodies in [begin, end)
+void directAccelerations(const std::vector<float> &x, const std::vector<float> &y, const std::vector<float> &mass,
+                         float gravity, float softening, int begin, int end, std::vector<float> &ax, std::vector<float> &ay);
+
+// a disc of bodies, denser in the middle
+void makeDisc(int count, float centerX, float centerY, float radius, unsigned seed,
+              std::vector<float> &x, std::vector<float> &y, std::vector<float> &mass);
@@ -0,0 +1,559 @@
+#pragma once
+
+#include "../common/snapshot.hpp"
+#include "../common/vec2.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// event driven (discrete event) hard sphere engine
+// instead of stepping time in fixed increments, the time of every future wall, ball-ball and cell crossing event is predicted
+// and the simulation jumps straight from one event to the next. in a dilute gas most fixed steps contain no collision at all,
+// so this does work proportional to the number of collisions instead of the number of steps
+//
+// balls are only moved when they take part in an event, each one stores its state at its own time t.
+// all balls share the same constant acceleration, so relative motion between two balls is linear and pair times are a quadratic.
+// predicted events are kept in a binary heap; instead of removing events when a ball changes velocity, every event remembers the
+// collision counts of its balls at prediction time and is thrown away when popped if a count has moved on (lazy invalidation)
+//
+// references: Rapaport, "The Art of Molecular Dynamics Simulation" (ch. 14) and Sedgewick & Wayne's CollisionSystem
+
+struct HardSphere
+{
+    double x, y;
+    double vx, vy;
+    double t; // time at which x, y, vx, vy are valid
+    double radius;
+    double mass;
+    int collisionCount; // bumped on every velocity change
+    int cellX, cellY;
+    int unused; // explicit padding, so snapshots of equal states are equal byte for byte
+    double lastCollisionTime; // for the TC rule, see EventDrivenSimulation::TC
+};
+
+enum class EventType
+{
+    Wall,
+    Pair,
+    Cell
+};
+
+struct CollisionEvent
+{
+    double time;
+    EventType type;
+    int a, b; // b is only used by pair events
+    int countA, countB;
+    int axis; // 0 = x, 1 = y, for wall and cell events
+    int dir;  // -1 / +1, direction of a cell crossing
+    int unused = 0; // explicit padding, see HardSphere
+
+    // std::push_heap builds a max heap, so invert the comparison to get the earliest event on top
+    bool operator<(const CollisionEvent &other) const { return time > other.time; }
+};
+
+class EventDrivenSimulation
+{
+public:
+    std::vector<HardSphere> balls;
+    double time = 0.0;
+    long long eventCount = 0;    // valid events processed
+    long long staleEventCount = 0; // invalidated events popped and discarded
+
+    EventDrivenSimulation(const Box &boxBounds, double ax = 0.0, double ay = 0.0, double restitution = 1.0)
+        : left(boxBounds.left), top(boxBounds.top),
+          right(boxBounds.left + boxBounds.width), bottom(boxBounds.top + boxBounds.height),
+          ax(ax), ay(ay), restitution(restitution) {}
+
+    void addBall(double x, double y, double radius, double vx, double vy)
+    {
+        balls.push_back({x, y, vx, vy, time, radius, radius * radius, 0, 0, 0, 0, -1.0});
+    }
+
+    // builds the cell grid and predicts the first events, call after all balls have been added
+    void initialize()
+    {
+        double maxRadius = 0.0;
+        for (const auto &ball : balls)
+            maxRadius = std::max(maxRadius, ball.radius);
+
+        // two balls can only touch if their centres are within 2 * maxRadius, so with cells at least that wide
+        // every possible partner of a ball is in its 3x3 neighbourhood at the moment of contact.
+        // in a dilute gas that is much smaller than the spacing between balls and cell crossings would dominate the event count,
+        // so cells are sized to hold about one ball each
+        // with no balls one cell covers the box, a tiny fallback size would make the grid overflow
+        double spacing = balls.empty() ? std::max(right - left, bottom - top) : std::sqrt((right - left) * (bottom - top) / balls.size());
+        cellSize = std::max({2.0 * maxRadius, spacing, 1e-6});
+        gridW = std::max(1, static_cast<int>(std::ceil((right - left) / cellSize)));
+        gridH = std::max(1, static_cast<int>(std::ceil((bottom - top) / cellSize)));
+        cells.assign(gridW * gridH, {});
+
+        for (size_t i = 0; i < balls.size(); ++i)
+        {
+            HardSphere &ball = balls[i];
+            ball.cellX = std::clamp(static_cast<int>((ball.x - left) / cellSize), 0, gridW - 1);
+            ball.cellY = std::clamp(static_cast<int>((ball.y - top) / cellSize), 0, gridH - 1);
+            cells[ball.cellY * gridW + ball.cellX].push_back(static_cast<int>(i));
+        }
+
+        events.clear();
+        for (size_t i = 0; i < balls.size(); ++i)
+        {
+            predictWall(static_cast<int>(i));
+            predictCell(static_cast<int>(i));
+            // only look at higher indices so each pair is predicted once
+            forEachNeighbour(static_cast<int>(i), [&](int j)
+                             { if (j > static_cast<int>(i)) predictPair(static_cast<int>(i), j); });
+        }
+    }
+
+    // process every event up to time t, afterwards positionAt(i, t) gives the state at t
+    void advanceTo(double t)
+    {
+        while (!events.empty() && events.front().time <= t)
+        {
+            std::pop_heap(events.begin(), events.end());
+            CollisionEvent event = events.back();
+            events.pop_back();
+
+            if (!isValid(event))
+            {
+                staleEventCount++;
+                continue;
+            }
+
+            time = event.time;
+            eventCount++;
+            switch (event.type)
+            {
+            case EventType::Wall:
+                handleWall(event);
+                break;
+            case EventType::Pair:
+                handlePair(event);
+                break;
+            case EventType::Cell:
+                handleCell(event);
+                break;
+            }
+
+            // every velocity change leaves stale events behind, compact the heap once they dominate
+            if (events.size() > 16 * balls.size() + 1024)
+                compactEvents();
+        }
+        time = t;
+    }
+
+    Vec2 positionAt(int i, double t) const
+    {
+        const HardSphere &ball = balls[i];
+        double dt = t - ball.t;
+        return Vec2(static_cast<float>(ball.x + ball.vx * dt + 0.5 * ax * dt * dt),
+                            static_cast<float>(ball.y + ball.vy * dt + 0.5 * ay * dt * dt));
+    }
+
+    double kineticEnergy() const
+    {
+        double energy = 0.0;
+        for (const auto &ball : balls)
+        {
+            double dt = time - ball.t;
+            double vx = ball.vx + ax * dt;
+            double vy = ball.vy + ay * dt;
+            energy += 0.5 * ball.mass * (vx * vx + vy * vy);
+        }
+        return energy;
+    }
+
+    // everything advanceTo depends on goes in the snapshot, including the order of every cell list and the exact
+    // layout of the event heap: both decide which of two simultaneous events is handled first, so rebuilding them
+    // with initialize() would give a valid but different continuation
+    void save(SnapshotWriter &writer) const
+    {
+        std::vector<int> cellStart(1, 0), cellBalls;
+        for (const auto &cell : cells)
+        {
+            cellBalls.insert(cellBalls.end(), cell.begin(), cell.end());
+            cellStart.push_back(static_cast<int>(cellBalls.size()));
+        }
+        writer.value("world", World{left, top, right, bottom, ax, ay, restitution, time, cellSize,
+                                    eventCount, staleEventCount, gridW, gridH});
+        writer.array("spheres", balls);
+        writer.array("cells", cellStart);
+        writer.array("cellball", cellBalls);
+        writer.array("events", events);
+    }
+
+    bool load(SnapshotReader &reader)
+    {
+        World world;
+        std::vector<int> cellStart, cellBalls;
+        reader.value("world", world);
+        reader.array("spheres", balls);
+        reader.array("cells", cellStart);
+        reader.array("cellball", cellBalls);
+        reader.array("events", events);
+        if (!reader.ok() || world.gridW < 1 || world.gridH < 1 || cellStart.size() != static_cast<size_t>(world.gridW) * world.gridH + 1 ||
+            cellStart.front() != 0 || cellStart.back() != static_cast<int>(cellBalls.size()) || !std::is_sorted(cellStart.begin(), cellStart.end()) ||
+            !consistent(world, cellStart, cellBalls))
+            return false;
+
+        left = world.left;
+        top = world.top;
+        right = world.right;
+        bottom = world.bottom;
+        ax = world.ax;
+        ay = world.ay;
+        restitution = world.restitution;
+        time = world.time;
+        cellSize = world.cellSize;
+        eventCount = world.eventCount;
+        staleEventCount = world.staleEventCount;
+        gridW = world.gridW;
+        gridH = world.gridH;
+        cells.assign(gridW * gridH, {});
+        for (size_t c = 0; c < cells.size(); ++c)
+            cells[c].assign(cellBalls.begin() + cellStart[c], cellBalls.begin() + cellStart[c + 1]);
+        return true;
+    }
+
+private:
+    struct World
+    {
+        double left, top, right, bottom;
+        double ax, ay;
+        double restitution;
+        double time;
+        double cellSize;
+        long long eventCount, staleEventCount;
+        int gridW, gridH;
+    };
+
+    double left, top, right, bottom;
+    double ax, ay;
+    double restitution; // for wall and ball-ball collisions alike
+
+    // with restitution < 1 and gravity a ball resting on the floor, or on other balls, would bounce infinitely often in
+    // finite time (inelastic collapse)
+    // TC model (Luding & McNamara): a collision within TC of the ball's previous one, wall or pair, is treated as elastic.
+    // a pile of resting balls then chatters at no more than about (contacts per ball) / TC events per ball and second,
+    // 1e-2 keeps 300 settled balls near 50000 events/s, at 1e-4 the same pile ran away to millions
+    static constexpr double TC = 1e-2;
+
+    double cellSize = 1.0;
+    int gridW = 1, gridH = 1;
+    std::vector<std::vector<int>> cells;
+    std::vector<CollisionEvent> events;
+
+    // every index in a loaded snapshot is used unchecked later: each ball must be listed exactly once, in the cell it
+    // says it is in, and every event must refer to existing balls
+    bool consistent(const World &world, const std::vector<int> &cellStart, const std::vector<int> &cellBalls) const
+    {
+        if (!(world.cellSize > 0.0) || cellBalls.size() != balls.size())
+            return false;
+        std::vector<char> listed(balls.size(), 0);
+        for (size_t c = 0; c + 1 < cellStart.size(); ++c)
+        {
+            for (int k = cellStart[c]; k < cellStart[c + 1]; ++k)
+            {
+                int i = cellBalls[k];
+                if (i < 0 || i >= static_cast<int>(balls.size()) || listed[i])
+                    return false;
+                const HardSphere &ball = balls[i];
+                if (ball.cellX < 0 || ball.cellX >= world.gridW || ball.cellY < 0 || ball.cellY >= world.gridH ||
+                    static_cast<size_t>(ball.cellY) * world.gridW + ball.cellX != c)
+                    return false;
+                listed[i] = 1;
+            }
+        }
+
+        int count = static_cast<int>(balls.size());
+        for (const auto &event : events)
+        {
+            if (event.a < 0 || event.a >= count)
+                return false;
+            switch (event.type)
+            {
+            case EventType::Pair:
+                if (event.b < 0 || event.b >= count)
+                    return false;
+                break;
+            case EventType::Wall:
+                if (event.axis != 0 && event.axis != 1)
+                    return false;
+                break;
+            case EventType::Cell:
+                if ((event.axis != 0 && event.axis != 1) || (event.dir != -1 && event.dir != 1))
+                    return false;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // move a ball along its parabola up to time t, this does not change its trajectory
+    void propagate(HardSphere &ball, double t) const
+    {
+        double dt = t - ball.t;
+        ball.x += ball.vx * dt + 0.5 * ax * dt * dt;
+        ball.y += ball.vy * dt + 0.5 * ay * dt * dt;
+        ball.vx += ax * dt;
+        ball.vy += ay * dt;
+        ball.t = t;
+    }
+
+    // earliest t >= 0 at which p + v t + a t^2 / 2 reaches bound while moving in direction side (+1 increasing, -1 decreasing)
+    static double crossingTime(double p, double v, double a, double bound, int side)
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        double c = p - bound;
+
+        // already past the bound and still moving outwards (round off), handle immediately
+        if (c * side >= 0.0 && v * side > 0.0)
+            return 0.0;
+
+        if (std::abs(a) < 1e-12)
+        {
+            if (v * side <= 0.0)
+                return inf;
+            double t = -c / v;
+            return t >= 0.0 ? t : inf;
+        }
+
+        double disc = v * v - 2.0 * a * c;
+        if (disc < 0.0)
+            return inf;
+
+        // numerically stable roots of (a/2) t^2 + v t + c = 0
+        double q = -0.5 * (v + std::copysign(std::sqrt(disc), v));
+        double t1 = q / (0.5 * a);
+        double t2 = q != 0.0 ? c / q : t1;
+        if (t1 > t2)
+            std::swap(t1, t2);
+
+        for (double t : {t1, t2})
+        {
+            if (t >= 0.0 && (v + a * t) * side > 0.0)
+                return t;
+        }
+        return inf;
+    }
+
+    bool isValid(const CollisionEvent &event) const
+    {
+        if (balls[event.a].collisionCount != event.countA)
+            return false;
+        return event.type != EventType::Pair || balls[event.b].collisionCount == event.countB;
+    }
+
+    void pushEvent(const CollisionEvent &event)
+    {
+        events.push_back(event);
+        std::push_heap(events.begin(), events.end());
+    }
+
+    void compactEvents()
+    {
+        events.erase(std::remove_if(events.begin(), events.end(),
+                                    [this](const CollisionEvent &event)
+                                    { return !isValid(event); }),
+                     events.end());
+        std::make_heap(events.begin(), events.end());
+    }
+
+    template <typename F>
+    void forEachNeighbour(int i, F &&f) const
+    {
+        const HardSphere &ball = balls[i];
+        for (int cy = std::max(0, ball.cellY - 1); cy <= std::min(gridH - 1, ball.cellY + 1); ++cy)
+            for (int cx = std::max(0, ball.cellX - 1); cx <= std::min(gridW - 1, ball.cellX + 1); ++cx)
+                for (int j : cells[cy * gridW + cx])
+                    if (j != i)
+                        f(j);
+    }
+
+    void predictWall(int i)
+    {
+        const HardSphere &ball = balls[i];
+        double best = std::numeric_limits<double>::infinity();
+        int axis = 0;
+
+        double tx = std::min(crossingTime(ball.x, ball.vx, ax, left + ball.radius, -1),
+                             crossingTime(ball.x, ball.vx, ax, right - ball.radius, +1));
+        double ty = std::min(crossingTime(ball.y, ball.vy, ay, top + ball.radius, -1),
+                             crossingTime(ball.y, ball.vy, ay, bottom - ball.radius, +1));
+        if (tx < best)
+        {
+            best = tx;
+            axis = 0;
+        }
+        if (ty < best)
+        {
+            best = ty;
+            axis = 1;
+        }
+        if (std::isfinite(best))
+            pushEvent({ball.t + best, EventType::Wall, i, -1, ball.collisionCount, 0, axis, 0});
+    }
+
+    void predictCell(int i)
+    {
+        const HardSphere &ball = balls[i];
+        double best = std::numeric_limits<double>::infinity();
+        int axis = 0, dir = 0;
+
+        auto consider = [&](double t, int a, int d)
+        {
+            if (t < best)
+            {
+                best = t;
+                axis = a;
+                dir = d;
+            }
+        };
+
+        double cellLeft = left + ball.cellX * cellSize;
+        double cellTop = top + ball.cellY * cellSize;
+        if (ball.cellX > 0)
+            consider(crossingTime(ball.x, ball.vx, ax, cellLeft, -1), 0, -1);
+        if (ball.cellX < gridW - 1)
+            consider(crossingTime(ball.x, ball.vx, ax, cellLeft + cellSize, +1), 0, +1);
+        if (ball.cellY > 0)
+            consider(crossingTime(ball.y, ball.vy, ay, cellTop, -1), 1, -1);
+        if (ball.cellY < gridH - 1)
+            consider(crossingTime(ball.y, ball.vy, ay, cellTop + cellSize, +1), 1, +1);
+
+        if (std::isfinite(best))
+            pushEvent({ball.t + best, EventType::Cell, i, -1, ball.collisionCount, 0, axis, dir});
+    }
+
+    void predictPair(int i, int j)
+    {
+        HardSphere &a = balls[i];
+        HardSphere &b = balls[j];
+        // bring both up to the current time, they stay on their trajectories so their other events remain valid
+        propagate(a, time);
+        propagate(b, time);
+
+        double dx = b.x - a.x;
+        double dy = b.y - a.y;
+        double dvx = b.vx - a.vx;
+        double dvy = b.vy - a.vy;
+        double sigma = a.radius + b.radius;
+
+        double bdot = dx * dvx + dy * dvy;
+        if (bdot >= 0.0)
+            return; // separating
+
+        double dvv = dvx * dvx + dvy * dvy;
+        double c = dx * dx + dy * dy - sigma * sigma;
+        double t;
+        if (c <= 0.0)
+        {
+            t = 0.0; // overlapping from round off and approaching
+        }
+        else
+        {
+            double disc = bdot * bdot - dvv * c;
+            if (disc < 0.0)
+                return; // they miss each other
+            t = c / (-bdot + std::sqrt(disc));
+        }
+        pushEvent({time + t, EventType::Pair, i, j, a.collisionCount, b.collisionCount, 0, 0});
+    }
+
+    // new velocity for ball i, predict everything it takes part in again
+    void repredict(int i)
+    {
+        predictWall(i);
+        predictCell(i);
+        forEachNeighbour(i, [&](int j)
+                         { predictPair(i, j); });
+    }
+
+    void handleWall(const CollisionEvent &event)
+    {
+        HardSphere &ball = balls[event.a];
+        propagate(ball, time);
+
+        double e = (time - ball.lastCollisionTime < TC) ? 1.0 : restitution;
+        ball.lastCollisionTime = time;
+
+        // snap onto the wall to stop round off from accumulating
+        if (event.axis == 0)
+        {
+            ball.x = ball.vx < 0.0 ? left + ball.radius : right - ball.radius;
+            ball.vx = -ball.vx * e;
+        }
+        else
+        {
+            ball.y = ball.vy < 0.0 ? top + ball.radius : bottom - ball.radius;
+            ball.vy = -ball.vy * e;
+        }
+        ball.collisionCount++;
+        repredict(event.a);
+    }
+
+    void handlePair(const CollisionEvent &event)
+    {
+        HardSphere &a = balls[event.a];
+        HardSphere &b = balls[event.b];
+        propagate(a, time);
+        propagate(b, time);
+
+        double dx = b.x - a.x;
+        double dy = b.y - a.y;
+        double dist = std::hypot(dx, dy);
+        if (dist > 0.0)
+        {
+            double nx = dx / dist;
+            double ny = dy / dist;
+            double vn = (b.vx - a.vx) * nx + (b.vy - a.vy) * ny;
+            // the TC rule applies per ball: if either one was hit within TC the contact is elastic
+            double e = (time - a.lastCollisionTime < TC || time - b.lastCollisionTime < TC) ? 1.0 : restitution;
+            // impulse for a collision with restitution e between unequal masses
+            double j = (1.0 + e) * a.mass * b.mass * vn / (a.mass + b.mass);
+            a.vx += j / a.mass * nx;
+            a.vy += j / a.mass * ny;
+            b.vx -= j / b.mass * nx;
+            b.vy -= j / b.mass * ny;
+        }
+
+        a.lastCollisionTime = time;
+        b.lastCollisionTime = time;
+        a.collisionCount++;
+        b.collisionCount++;
+        repredict(event.a);
+        repredict(event.b);
+    }
+
+    void handleCell(const CollisionEvent &event)
+    {
+        HardSphere &ball = balls[event.a];
+        propagate(ball, time);
+
+        std::vector<int> &oldCell = cells[ball.cellY * gridW + ball.cellX];
+        oldCell.erase(std::find(oldCell.begin(), oldCell.end(), event.a));
+        if (event.axis == 0)
+            ball.cellX += event.dir;
+        else
+            ball.cellY += event.dir;
+        cells[ball.cellY * gridW + ball.cellX].push_back(event.a);
+
+        // the trajectory is unchanged, so existing events stay valid (no count bump)
+        // only the row or column of cells that just came into the neighbourhood has new partners
+        for (int k = -1; k <= 1; ++k)
+        {
+            int cx = event.axis == 0 ? ball.cellX + event.dir : ball.cellX + k;
+            int cy = event.axis == 0 ? ball.cellY + k : ball.cellY + event.dir;
+            if (cx < 0 || cx >= gridW || cy < 0 || cy >= gridH)
+                continue;
+            for (int j : cells[cy * gridW + cx])
+                predictPair(event.a, j);
+        }
+        predictCell(event.a);
+    }
+};
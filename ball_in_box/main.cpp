@@ -1,82 +1,224 @@
+#include "../renderer/renderer.hpp"
+#include "ball.hpp"
+#include "barnes_hut.hpp"
+#include "event_sim.hpp"
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
-// g++ -o main main.cpp -I/opt/homebrew/opt/sfml/include -L/opt/homebrew/opt/sfml/lib -lsfml-graphics -lsfml-window -lsfml-system
+// viewer, the physics is in ball.hpp, event_sim.hpp and barnes_hut.hpp
 
-// ./main
+// built by the top level CMakeLists.txt when SFML is found
+
+// ./main                  single ball, time stepped
+// ./main --events 300     300 balls, event driven
+// ./main --pile 300       the same under gravity with restitution 0.8, they settle into a pile
+// ./main --nbody 20000    mutually attracting balls, Barnes-Hut forces
+// ./main --attach balls   draws the frames `headless ball|events|nbody --publish balls` streams through shared memory
 
 // ./run_and_watch.sh
 
-class Ball
+// many balls with the event driven engine, the render loop only samples the state at frame times
+int runEventDriven(int count, bool gravity)
 {
-public:
-    sf::CircleShape shape;
-    float vx, vy;
-    float ax, ay;
-    float radius;
-    float restitution; // coefficient of restitution between the ball and the wall
-
-    Ball(float x, float y, float radius, float vx, float vy, float ax = 0, float ay = 0, float restitution = 1.0f) : vx(vx), vy(vy), ax(ax), ay(ay), radius(radius), restitution(restitution)
+    sf::RenderWindow window(sf::VideoMode(800, 600), "Ball in a Box - Event Driven");
+    window.setFramerateLimit(60);
+
+    Box boxBounds(100, 100, 600, 400);
+
+    BatchRenderer renderer;
+
+    EventDrivenSimulation sim(boxBounds, 0.0, gravity ? 980.0 : 0.0, gravity ? 0.8 : 1.0);
+    scatterBalls(boxBounds, count, 4.0f, 150.0f, 42, [&](float x, float y, float r, float vx, float vy)
+                 { sim.addBall(x, y, r, vx, vy); });
+    sim.initialize();
+
+    sf::Clock clock;
+    double simTime = 0.0;
+
+    while (window.isOpen())
     {
-        shape.setPosition(x, y);
-        shape.setRadius(radius);
-        shape.setFillColor(sf::Color::Red);
-        shape.setOrigin(radius, radius);
+        sf::Event event;
+        while (window.pollEvent(event))
+        {
+            if (event.type == sf::Event::Closed)
+            {
+                window.close();
+            }
+        }
+
+        simTime += clock.restart().asSeconds();
+        sim.advanceTo(simTime);
+
+        renderer.begin();
+        renderer.rectOutline(toSf(boxBounds), 5, sf::Color::White);
+        for (size_t i = 0; i < sim.balls.size(); ++i)
+            renderer.circle(toSf(sim.positionAt(static_cast<int>(i), simTime)), static_cast<float>(sim.balls[i].radius), sf::Color::Red);
+
+        window.clear(sf::Color::Black);
+        renderer.flush(window);
+        window.display();
     }
+    return 0;
+}
+
+// mutually attracting balls, the Barnes-Hut pass replaces the constant ax, ay of every ball each frame
+int runNBody(int count)
+{
+    sf::RenderWindow window(sf::VideoMode(800, 600), "Ball in a Box - Barnes-Hut");
+    window.setFramerateLimit(60);
+
+    Box boxBounds(100, 100, 600, 400);
+
+    BatchRenderer renderer;
+
+    const Vec2 center(boxBounds.left + boxBounds.width / 2, boxBounds.top + boxBounds.height / 2);
+    const int threads = hardwareThreads();
+
+    std::vector<float> x, y, mass, ax, ay;
+    makeDisc(count, center.x, center.y, 180.0f, 7, x, y, mass);
+
+    BarnesHutTree tree;
+    tree.theta = 0.7f;
+    tree.gravity = 2e6f / count; // keeps the total mass, and so the rotation speed, independent of count
+    tree.softening = 2.0f;
+    tree.build(x, y, mass);
+    tree.computeAccelerations(x, y, ax, ay, threads);
 
-    void update(float dt, sf::FloatRect boxBounds)
+    // start every body on a roughly circular orbit: |v|^2 / r = radial acceleration
+    std::vector<Ball> balls;
+    balls.reserve(count);
+    for (int i = 0; i < count; ++i)
     {
-        sf::Vector2f position = shape.getPosition();
+        float rx = x[i] - center.x;
+        float ry = y[i] - center.y;
+        float r = std::max(std::hypot(rx, ry), 1e-3f);
+        float radial = std::max(0.0f, -(ax[i] * rx + ay[i] * ry) / r);
+        float speed = std::sqrt(radial * r);
+        balls.emplace_back(x[i], y[i], 1.0f, -speed * ry / r, speed * rx / r, 0.0f, 0.0f, 0.5f);
+    }
+
+    sf::Clock clock;
 
-        vx += ax * dt;
-        vy += ay * dt;
+    while (window.isOpen())
+    {
+        sf::Event event;
+        while (window.pollEvent(event))
+        {
+            if (event.type == sf::Event::Closed)
+            {
+                window.close();
+            }
+        }
 
-        position.x += vx * dt;
-        position.y += vy * dt;
+        float dt = std::min(clock.restart().asSeconds(), 1.0f / 30.0f);
 
-        // collision with left wall
-        if (position.x - radius < boxBounds.left)
+        for (int i = 0; i < count; ++i)
         {
-            position.x = boxBounds.left + radius;
-            vx = -vx * restitution;
+            x[i] = balls[i].x;
+            y[i] = balls[i].y;
         }
-        // collision with right wall
-        else if (position.x + radius > boxBounds.left + boxBounds.width)
+        tree.build(x, y, mass);
+        tree.computeAccelerations(x, y, ax, ay, threads);
+        for (int i = 0; i < count; ++i)
         {
-            position.x = boxBounds.left + boxBounds.width - radius;
-            vx = -vx * restitution;
+            balls[i].ax = ax[i];
+            balls[i].ay = ay[i];
+            balls[i].update(dt, boxBounds);
         }
-        // collision with top wall
-        if (position.y - radius < boxBounds.top)
+
+        renderer.begin();
+        renderer.rectOutline(toSf(boxBounds), 5, sf::Color::White);
+        for (const auto &ball : balls)
+            renderer.circle(sf::Vector2f(ball.x, ball.y), ball.radius, sf::Color::Red);
+
+        window.clear(sf::Color::Black);
+        renderer.flush(window);
+        window.display();
+    }
+    return 0;
+}
+
+// the balls move in another process, this one maps its frame ring read-only and draws the newest frame each time;
+// attaching, detaching or a slow viewer never holds the simulation back. the last frame stays up until a writer returns
+int runAttached(const std::string &name)
+{
+    sf::RenderWindow window(sf::VideoMode(800, 600), "Ball in a Box - " + frameRingPath(name));
+    window.setFramerateLimit(60);
+
+    Box boxBounds(100, 100, 600, 400);
+
+    BatchRenderer renderer;
+
+    FrameRingReader ring;
+    Frame frame;
+    sf::Clock retryClock;
+    bool firstTry = true;
+
+    while (window.isOpen())
+    {
+        sf::Event event;
+        while (window.pollEvent(event))
         {
-            position.y = boxBounds.top + radius;
-            vy = -vy * restitution;
+            if (event.type == sf::Event::Closed)
+            {
+                window.close();
+            }
         }
-        // collision with bottom wall
-        else if (position.y + radius > boxBounds.top + boxBounds.height)
+
+        if (ring.closed() && (firstTry || retryClock.getElapsedTime().asSeconds() > 0.5f))
         {
-            position.y = boxBounds.top + boxBounds.height - radius;
-            vy = -vy * restitution;
+            firstTry = false;
+            retryClock.restart();
+            if (ring.open(name))
+                frame.index = 0;
         }
-        shape.setPosition(position);
+        ring.latest(frame);
+
+        renderer.begin();
+        renderer.rectOutline(toSf(boxBounds), 5, sf::Color::White);
+        float radius = ring.isOpen() ? ring.radius() : 1.0f;
+        for (const Vec2 &position : frame.positions)
+            renderer.circle(toSf(position), radius, sf::Color::Red);
+
+        window.clear(sf::Color::Black);
+        renderer.flush(window);
+        window.display();
     }
-};
+    return 0;
+}
 
-int main()
+int main(int argc, char **argv)
 {
+    if (argc > 1 && std::strcmp(argv[1], "--attach") == 0)
+    {
+        return runAttached(argc > 2 ? argv[2] : "balls");
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--nbody") == 0)
+    {
+        return runNBody(argc > 2 ? std::atoi(argv[2]) : 20000);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--events") == 0)
+    {
+        return runEventDriven(argc > 2 ? std::atoi(argv[2]) : 300, false);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--pile") == 0)
+    {
+        return runEventDriven(argc > 2 ? std::atoi(argv[2]) : 300, true);
+    }
+
     sf::RenderWindow window(sf::VideoMode(800, 600), "Ball in a Box - Elastic Collision");
 
     // discrete collision detection, to take care of tunneling
     window.setFramerateLimit(60);
 
-    sf::FloatRect boxBounds(100, 100, 600, 400);
+    Box boxBounds(100, 100, 600, 400);
 
-    sf::RectangleShape boxOutline;
-    boxOutline.setPosition(boxBounds.left, boxBounds.top);
-    boxOutline.setSize(sf::Vector2f(boxBounds.width, boxBounds.height));
-    boxOutline.setFillColor(sf::Color::Transparent);
-    boxOutline.setOutlineThickness(5);
-    boxOutline.setOutlineColor(sf::Color::White);
+    BatchRenderer renderer;
 
     // assuming scaling factor is such that 1 meter = 100 pixels
     float gPixels = 980.0f;
@@ -100,10 +242,12 @@ int main()
         float dt = clock.restart().asSeconds();
         ball.update(dt, boxBounds);
 
-        window.clear(sf::Color::Black);
+        renderer.begin();
+        renderer.rectOutline(toSf(boxBounds), 5, sf::Color::White);
+        renderer.circle(sf::Vector2f(ball.x, ball.y), ball.radius, sf::Color::Red);
 
-        window.draw(boxOutline);
-        window.draw(ball.shape);
+        window.clear(sf::Color::Black);
+        renderer.flush(window);
         window.display();
     }
     return 0;
@@ -0,0 +1,223 @@
+#include "../ball_in_box/ball.hpp"
+#include "../ball_in_box/barnes_hut.hpp"
+#include "../ball_in_box/event_sim.hpp"
+#include "bench.hpp"
+
+// size is a number of balls (or bodies for the Barnes-Hut pass)
+
+namespace
+{
+    // a dilute gas in a square box sized for 5% area coverage, the same setup for both collision engines
+    const float GAS_RADIUS = 2.0f;
+    const float GAS_SPEED = 200.0f;
+
+    Box gasBox(int count)
+    {
+        float side = std::sqrt(count * static_cast<float>(M_PI) * GAS_RADIUS * GAS_RADIUS / 0.05f);
+        return Box(0, 0, side, side);
+    }
+
+    // Ball::update alone (integration and walls), no ball-ball collisions
+    void update(BenchContext &context)
+    {
+        Box bounds = gasBox(context.size);
+        std::vector<Ball> balls;
+        balls.reserve(context.size);
+        scatterBalls(bounds, context.size, GAS_RADIUS, GAS_SPEED, 1234, [&](float x, float y, float r, float vx, float vy)
+                     { balls.emplace_back(x, y, r, vx, vy, 0.0f, 980.0f, 0.8f); });
+
+        context.measure(static_cast<double>(context.size), [&]
+                        { parallelFor(context.size, context.threads, [&](int begin, int end)
+                                      {
+                                          for (int i = begin; i < end; ++i)
+                                              balls[i].update(1.0f / 480.0f, bounds);
+                                      }); });
+    }
+
+    // 0.1 s of the gas with stepBalls at dt 1/480 (small enough that balls do not tunnel)
+    void timeStepped(BenchContext &context)
+    {
+        Box bounds = gasBox(context.size);
+        std::vector<Ball> balls;
+        balls.reserve(context.size);
+        scatterBalls(bounds, context.size, GAS_RADIUS, GAS_SPEED, 1234, [&](float x, float y, float r, float vx, float vy)
+                     { balls.emplace_back(x, y, r, vx, vy); });
+
+        context.measure(static_cast<double>(context.size), [&]
+                        {
+                            for (int i = 0; i < 48; ++i)
+                                stepBalls(balls, 1.0f / 480.0f, bounds);
+                        });
+    }
+
+    // the same 0.1 s of gas with the event driven engine, every run continues where the last one stopped
+    void eventDriven(BenchContext &context)
+    {
+        Box bounds = gasBox(context.size);
+        EventDrivenSimulation sim(bounds);
+        scatterBalls(bounds, context.size, GAS_RADIUS, GAS_SPEED, 1234, [&](float x, float y, float r, float vx, float vy)
+                     { sim.addBall(x, y, r, vx, vy); });
+        sim.initialize();
+
+        long long startEvents = sim.eventCount;
+        context.measure(static_cast<double>(context.size), [&]
+                        { sim.advanceTo(sim.time + 0.1); });
+        context.counter("events_per_run", static_cast<double>(sim.eventCount - startEvents) / (context.repetitions + 1));
+    }
+
+    // 0.1 s of balls piled on the floor under gravity with restitution 0.8, after 5 s to settle. a collapsing pile
+    // (see EventDrivenSimulation::TC) shows up here as events_per_run running away
+    void eventPile(BenchContext &context)
+    {
+        Box bounds = gasBox(context.size);
+        EventDrivenSimulation sim(bounds, 0.0, 980.0, 0.8);
+        scatterBalls(bounds, context.size, GAS_RADIUS, GAS_SPEED, 1234, [&](float x, float y, float r, float vx, float vy)
+                     { sim.addBall(x, y, r, vx, vy); });
+        sim.initialize();
+        sim.advanceTo(5.0);
+
+        long long startEvents = sim.eventCount;
+        context.measure(static_cast<double>(context.size), [&]
+                        { sim.advanceTo(sim.time + 0.1); });
+        context.counter("events_per_run", static_cast<double>(sim.eventCount - startEvents) / (context.repetitions + 1));
+    }
+
+    // tree build plus one force pass at opening angle THETA_PERCENT / 100, registered for a sweep over theta.
+    // rms_error is against direct summation on a sample of bodies, relative to the rms acceleration of that sample,
+    // max_error is the worst single body of the sample relative to its own acceleration
+    template <int THETA_PERCENT>
+    void barnesHut(BenchContext &context)
+    {
+        std::vector<float> x, y, mass, ax, ay;
+        makeDisc(context.size, 0.0f, 0.0f, 1000.0f, 99, x, y, mass);
+        BarnesHutTree tree;
+        tree.theta = THETA_PERCENT / 100.0f;
+
+        context.measure(static_cast<double>(context.size), [&]
+                        {
+                            tree.build(x, y, mass);
+                            tree.computeAccelerations(x, y, ax, ay, context.threads);
+                        });
+
+        int sample = std::min(256, context.size);
+        std::vector<float> refX(context.size), refY(context.size);
+        directAccelerations(x, y, mass, tree.gravity, tree.softening, 0, sample, refX, refY);
+        double refSq = 0.0, errorSq = 0.0, maxError = 0.0;
+        for (int i = 0; i < sample; ++i)
+        {
+            double bodyRefSq = refX[i] * refX[i] + refY[i] * refY[i];
+            double bodyErrorSq = (ax[i] - refX[i]) * (ax[i] - refX[i]) + (ay[i] - refY[i]) * (ay[i] - refY[i]);
+            refSq += bodyRefSq;
+            errorSq += bodyErrorSq;
+            if (bodyRefSq > 0.0)
+                maxError = std::max(maxError, std::sqrt(bodyErrorSq / bodyRefSq));
+        }
+        context.counter("theta", tree.theta);
+        context.counter("rms_error", refSq > 0.0 ? std::sqrt(errorSq / refSq) : 0.0);
+        context.counter("max_error", maxError);
+        context.counter("nodes", static_cast<double>(tree.nodeCount()));
+    }
+
+    // the O(n^2) reference the Barnes-Hut pass replaces
+    void directSum(BenchContext &context)
+    {
+        std::vector<float> x, y, mass, ax(context.size), ay(context.size);
+        makeDisc(context.size, 0.0f, 0.0f, 1000.0f, 99, x, y, mass);
+
+        context.measure(static_cast<double>(context.size), [&]
+                        { parallelFor(context.size, context.threads, [&](int begin, int end)
+                                      { directAccelerations(x, y, mass, 1.0f, 1.0f, begin, end, ax, ay); }); });
+    }
+
+    // the balls of the publish benchmarks and a ring for them, false (and the benchmark failed) if there is no shared memory
+    bool publishSetup(BenchContext &context, std::vector<Ball> &balls, Box &bounds, FrameRingWriter &ring)
+    {
+        bounds = gasBox(context.size);
+        balls.reserve(context.size);
+        scatterBalls(bounds, context.size, GAS_RADIUS, GAS_SPEED, 1234, [&](float x, float y, float r, float vx, float vy)
+                     { balls.emplace_back(x, y, r, vx, vy, 0.0f, 980.0f, 0.8f); });
+        const std::string name = "bench_ball_" + std::to_string(getpid());
+        if (!ring.create(name, "ball", balls.size(), 0, GAS_RADIUS))
+        {
+            context.fail("could not create the shared memory ring " + frameRingPath(name));
+            return false;
+        }
+        return true;
+    }
+
+    // what `headless nbody --publish` pays per step: its update pass writes the positions straight into the ring's
+    // next slot (beginFrame), so publishing is commitFrame alone, the same few stores at any size (no viewer attached,
+    // the writer does the same work either way). fused_update is that update pass over the plain Ball::update pass
+    void publish(BenchContext &context)
+    {
+        std::vector<Ball> balls;
+        Box bounds;
+        FrameRingWriter ring;
+        if (!publishSetup(context, balls, bounds, ring))
+            return;
+        long long frame = 0;
+        context.measure(static_cast<double>(context.size), [&]
+                        {
+                            ring.beginFrame(balls.size());
+                            ring.commitFrame(frame++);
+                        });
+        context.counter("frame_mb", balls.size() * sizeof(Vec2) / 1e6);
+        context.counter("publish_ns", context.result("").medianNs);
+
+        BenchContext plain(context.size, context.threads, context.repetitions);
+        update(plain);
+        BenchContext fused(context.size, context.threads, context.repetitions);
+        fused.measure(static_cast<double>(context.size), [&]
+                      {
+                          Vec2 *positions = ring.beginFrame(balls.size());
+                          parallelFor(context.size, context.threads, [&](int begin, int end)
+                                      {
+                                          for (int i = begin; i < end; ++i)
+                                          {
+                                              balls[i].update(1.0f / 480.0f, bounds);
+                                              positions[i] = Vec2(balls[i].x, balls[i].y);
+                                          }
+                                      });
+                          ring.commitFrame(frame++);
+                      });
+        double plainNs = plain.result("").medianNs;
+        context.counter("fused_update", plainNs > 0.0 ? fused.result("").medianNs / plainNs : 0.0);
+    }
+
+    // one publishBalls, the copy out of the balls that runs without a pass of their own to fuse it into pay (ball, events).
+    // vs_update is its median time over that of one Ball::update pass over the same balls with the same threads,
+    // the cheapest step there is
+    void publishCopy(BenchContext &context)
+    {
+        std::vector<Ball> balls;
+        Box bounds;
+        FrameRingWriter ring;
+        if (!publishSetup(context, balls, bounds, ring))
+            return;
+        long long frame = 0;
+        context.measure(static_cast<double>(context.size), [&]
+                        { publishBalls(ring, frame++, balls, context.threads); });
+        context.counter("frame_mb", balls.size() * sizeof(Vec2) / 1e6);
+
+        BenchContext step(context.size, context.threads, context.repetitions);
+        update(step);
+        double stepNs = step.result("").medianNs;
+        context.counter("vs_update", stepNs > 0.0 ? context.result("").medianNs / stepNs : 0.0);
+    }
+}
+
+void registerBallBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    benchmarks.push_back({"ball/update", {1000, 100000}, {1000000}, true, update});
+    benchmarks.push_back({"ball/time_stepped", {100, 1000, 10000}, {50000}, false, timeStepped});
+    benchmarks.push_back({"ball/event_driven", {100, 1000, 10000}, {50000}, false, eventDriven});
+    benchmarks.push_back({"ball/event_pile", {100, 1000}, {10000}, false, eventPile});
+    // the accuracy against speed trade of the opening angle, 0.5 is the tree's default
+    benchmarks.push_back({"ball/barnes_hut_theta_0.3", {1000, 10000, 100000}, {1000000}, true, barnesHut<30>});
+    benchmarks.push_back({"ball/barnes_hut", {1000, 10000, 100000}, {1000000}, true, barnesHut<50>});
+    benchmarks.push_back({"ball/barnes_hut_theta_0.7", {1000, 10000, 100000}, {1000000}, true, barnesHut<70>});
+    benchmarks.push_back({"ball/barnes_hut_theta_1.0", {1000, 10000, 100000}, {1000000}, true, barnesHut<100>});
+    benchmarks.push_back({"ball/publish", {1000, 100000, 1000000}, {}, true, publish});
+    benchmarks.push_back({"ball/publish_copy", {1000, 100000, 1000000}, {}, true, publishCopy});
+    benchmarks.push_back({"ball/direct_sum", {1000, 10000}, {30000}, true, directSum});
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+// tiny benchmark harness shared by the per simulation benchmark files
+//
+// a benchmark is a function that does its setup, then hands the timed kernel to BenchContext::measure.
+// measure runs it once to warm up and then `repetitions` times, keeping every timing, so the report can use the
+// median (stable against the odd descheduled run) and the minimum.
+// a benchmark that cannot run (a resource it needs is missing) calls fail() and returns, its result then carries the
+// error instead of timings, so it cannot be mistaken for a measurement
+
+struct BenchResult
+{
+    std::string name;
+    int size = 0;
+    int threads = 1;
+    int repetitions = 0;
+    double items = 0.0; // work items per run (particles updated, chains solved, ...), what the rates are per
+    double medianNs = 0.0;
+    double minNs = 0.0;
+    std::vector<std::pair<std::string, double>> counters; // extra numbers, e.g. an error against a reference
+    std::string error; // why the benchmark could not run, empty if it did
+};
+
+class BenchContext
+{
+public:
+    int size;
+    int threads;
+    int repetitions;
+
+    BenchContext(int size, int threads, int repetitions) : size(size), threads(threads), repetitions(repetitions) {}
+
+    template <typename F>
+    void measure(double itemsPerRun, F &&kernel)
+    {
+        items = itemsPerRun;
+        kernel(); // warm up caches, lazy allocations and the thread pool of the OS
+        timings.clear();
+        for (int r = 0; r < repetitions; ++r)
+        {
+            auto start = std::chrono::steady_clock::now();
+            kernel();
+            timings.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    void counter(const std::string &name, double value) { counters.emplace_back(name, value); }
+
+    void fail(const std::string &reason) { error = reason; }
+
+    BenchResult result(const std::string &name) const;
+
+private:
+    double items = 0.0;
+    std::vector<double> timings;
+    std::vector<std::pair<std::string, double>> counters;
+    std::string error;
+};
+
+struct Benchmark
+{
+    std::string name;       // "<simulation>/<kernel>", the key results are compared by
+    std::vector<int> sizes; // problem sizes for the default run
+    std::vector<int> fullSizes; // larger problem sizes added by --full
+    bool threaded;          // false: only run with one thread
+    void (*run)(BenchContext &context);
+};
+
+void registerBallBenchmarks(std::vector<Benchmark> &benchmarks);
+void registerClothBenchmarks(std::vector<Benchmark> &benchmarks);
+void registerPendulumBenchmarks(std::vector<Benchmark> &benchmarks);
+void registerSnakeBenchmarks(std::vector<Benchmark> &benchmarks);
+// only with SFML, see bench/render_bench.cpp
+void registerRenderBenchmarks(std::vector<Benchmark> &benchmarks);
@@ -0,0 +1,328 @@
+#include "../cloth_verlet/cloth.hpp"
+#include "bench.hpp"
+
+// size is the side of a size x size cloth built like resetSimulation builds the viewer's
+
+namespace
+{
+    struct Cloth
+    {
+        std::vector<Particle> particles;
+        std::vector<Constraint> constraints;
+
+        explicit Cloth(int side) { buildCloth(particles, constraints, side, side); }
+
+        // pins the whole top row and drops everything below by `distance`, as if the cloth had fallen for a moment and
+        // the top row had just caught it. the solve has to pull every row back up, an error that a relaxation sweep
+        // carries down only one row at a time
+        void drop(float distance)
+        {
+            for (auto &particle : particles)
+            {
+                if (particle.position.y < particles.front().position.y + 0.5f * REST_DISTANCE)
+                    particle.isPinned = true;
+                if (!particle.isPinned)
+                    particle.position.y += distance;
+                particle.previousPosition = particle.position;
+            }
+        }
+    };
+
+    // the largest stretch a solve to tolerance may leave, and the fall of drop() before it
+    const float STRETCH_TOLERANCE = 0.01f;
+    const float DROP_DISTANCE = 3.0f * REST_DISTANCE;
+
+    // CONSTRAINT_ITERATIONS sweeps of Constraint::satisfy in creation order, the inner loop of stepCloth.
+    // single threaded like stepCloth: each sweep sees the corrections made earlier in the same sweep
+    void constraintSatisfy(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        context.measure(static_cast<double>(cloth.constraints.size()) * CONSTRAINT_ITERATIONS, [&]
+                        {
+                            for (int i = 0; i < CONSTRAINT_ITERATIONS; ++i)
+                            {
+                                for (auto &constraint : cloth.constraints)
+                                    constraint.satisfy();
+                            } });
+    }
+
+    // time to tolerance of the relaxation in stepCloth: sweeps in creation order over a dropped cloth until no constraint
+    // is stretched by more than STRETCH_TOLERANCE. the number of sweeps is found first, the timed runs then do exactly
+    // that many without checking, and fine_sweeps reports it; it grows with the square of the side
+    void relaxToTolerance(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        cloth.drop(DROP_DISTANCE);
+        const std::vector<Particle> dropped = cloth.particles;
+
+        int sweeps = 0;
+        for (; sweeps < 100000 && maxStretch(cloth.constraints) > STRETCH_TOLERANCE; ++sweeps)
+        {
+            for (auto &constraint : cloth.constraints)
+                constraint.satisfy();
+        }
+
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        {
+                            // copied in place, the constraints point into the particle array
+                            std::copy(dropped.begin(), dropped.end(), cloth.particles.begin());
+                            for (int i = 0; i < sweeps; ++i)
+                            {
+                                for (auto &constraint : cloth.constraints)
+                                    constraint.satisfy();
+                            } });
+        context.counter("fine_sweeps", sweeps);
+        context.counter("stretch", maxStretch(cloth.constraints));
+    }
+
+    // the same dropped cloth solved with ClothMultigrid cycles (MULTIGRID_FINE_ITERATIONS fine sweeps each), found and
+    // timed the same way. the number of cycles stays the same as the cloth grows, so fine_sweeps is a small
+    // fraction of relax_to_tolerance's and the time grows with the particle count only
+    void multigridToTolerance(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        cloth.drop(DROP_DISTANCE);
+        const std::vector<Particle> dropped = cloth.particles;
+        ClothMultigrid multigrid(context.size, context.size);
+
+        int cycles = 0;
+        for (; cycles < 1000 && maxStretch(cloth.constraints) > STRETCH_TOLERANCE; ++cycles)
+            multigrid.solve(cloth.particles, cloth.constraints, MULTIGRID_FINE_ITERATIONS);
+
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        {
+                            std::copy(dropped.begin(), dropped.end(), cloth.particles.begin());
+                            for (int i = 0; i < cycles; ++i)
+                                multigrid.solve(cloth.particles, cloth.constraints, MULTIGRID_FINE_ITERATIONS); });
+        context.counter("cycles", cycles);
+        context.counter("fine_sweeps", cycles * MULTIGRID_FINE_ITERATIONS);
+        context.counter("levels", multigrid.levelCount());
+        context.counter("stretch", maxStretch(cloth.constraints));
+    }
+
+    // the cloth as the viewer hangs it, from its pins (every fifth particle of the top row and the last) under gravity,
+    // stepped HANG_STEPS times from rest before the timed steps. stretch is the largest stretch the step leaves, which is
+    // always the edge right below a pin carrying a whole strip of cloth, a local error only the fine sweeps reach.
+    // mean_stretch is the average over all edges, where the coarse levels pay off
+    const int HANG_STEPS = 600;
+
+    float meanStretch(const std::vector<Constraint> &constraints)
+    {
+        double sum = 0.0;
+        int active = 0;
+        for (const auto &constraint : constraints)
+        {
+            if (!constraint.isActive)
+                continue;
+            Vec2 delta = constraint.particle2->position - constraint.particle1->position;
+            sum += std::max(0.0f, (std::hypot(delta.x, delta.y) - constraint.restLength) / constraint.restLength);
+            active++;
+        }
+        return active > 0 ? static_cast<float>(sum / active) : 0.0f;
+    }
+
+    // stepCloth and its CONSTRAINT_ITERATIONS sweeps on the hanging cloth
+    void relaxHanging(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        for (int i = 0; i < HANG_STEPS; ++i)
+            stepCloth(cloth.particles, cloth.constraints);
+
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        { stepCloth(cloth.particles, cloth.constraints); });
+        context.counter("stretch", maxStretch(cloth.constraints));
+        context.counter("mean_stretch", meanStretch(cloth.constraints));
+    }
+
+    // stepCloth with a ClothMultigrid on the same hanging cloth
+    void multigridHanging(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        ClothMultigrid multigrid(context.size, context.size);
+        for (int i = 0; i < HANG_STEPS; ++i)
+            stepCloth(cloth.particles, cloth.constraints, multigrid);
+
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        { stepCloth(cloth.particles, cloth.constraints, multigrid); });
+        context.counter("stretch", maxStretch(cloth.constraints));
+        context.counter("mean_stretch", meanStretch(cloth.constraints));
+        context.counter("levels", multigrid.levelCount());
+    }
+
+    // force, Particle::update, damping and ground collision for every particle, the first half of stepCloth
+    void particleUpdate(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        { parallelFor(static_cast<int>(cloth.particles.size()), context.threads, [&](int begin, int end)
+                                      {
+                                          for (int i = begin; i < end; ++i)
+                                          {
+                                              Particle &particle = cloth.particles[i];
+                                              particle.applyForce(Vec2(0, GRAVITY));
+                                              particle.update(TIME_STEP);
+                                              particle.applyDamping(DAMPING);
+                                              particle.handleGroundCollision(HEIGHT - 1.0f);
+                                          }
+                                      }); });
+    }
+
+    // one ClothWind::apply on a cloth that has been blowing for a while, so triangles are sheared and lift is non zero.
+    // vs_constraint_solve is its median time over that of the CONSTRAINT_ITERATIONS sweeps stepCloth does on the same
+    // cloth (as in constraint_satisfy, always one thread), the cost the stage adds to a step in units of the solve
+    void wind(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        ClothWind clothWind(context.size, context.size);
+        clothWind.velocity = Vec2(400.0f, 60.0f);
+        for (int i = 0; i < 20; ++i)
+        {
+            clothWind.apply(cloth.particles, cloth.constraints, context.threads);
+            stepCloth(cloth.particles, cloth.constraints);
+        }
+
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        {
+                            clothWind.apply(cloth.particles, cloth.constraints, context.threads);
+                            // applyForce accumulates, keep the accelerations from growing run after run
+                            for (auto &particle : cloth.particles)
+                                particle.acceleration = Vec2(0, 0);
+                        });
+
+        BenchContext solve(context.size, 1, context.repetitions);
+        constraintSatisfy(solve);
+        double solveNs = solve.result("").medianNs;
+        context.counter("vs_constraint_solve", solveNs > 0.0 ? context.result("").medianNs / solveNs : 0.0);
+    }
+
+    // the whole fixed step as the viewer runs it
+    void step(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        { stepCloth(cloth.particles, cloth.constraints); });
+    }
+
+    // a ring for the publish benchmarks, false (and the benchmark failed) if there is no shared memory
+    bool publishRing(BenchContext &context, const Cloth &cloth, FrameRingWriter &ring)
+    {
+        const std::string name = "bench_cloth_" + std::to_string(getpid());
+        if (!ring.create(name, "cloth", cloth.particles.size(), context.size))
+        {
+            context.fail("could not create the shared memory ring " + frameRingPath(name));
+            return false;
+        }
+        return true;
+    }
+
+    // what `headless cloth --count N --publish` pays per step: the step's last sweep writes the positions straight into
+    // the ring's next slot (beginFrame), so publishing is commitFrame alone, the same few stores at any size (no viewer
+    // attached, the writer does the same work either way). fused_step is stepCloth with a ClothMultigrid writing the
+    // frame over the same step without
+    void publish(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        FrameRingWriter ring;
+        if (!publishRing(context, cloth, ring))
+            return;
+        long long frame = 0;
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        {
+                            ring.beginFrame(cloth.particles.size());
+                            ring.commitFrame(frame++);
+                        });
+        context.counter("frame_mb", cloth.particles.size() * sizeof(Vec2) / 1e6);
+        context.counter("publish_ns", context.result("").medianNs);
+
+        ClothMultigrid multigrid(context.size, context.size);
+        BenchContext plain(context.size, 1, std::min(context.repetitions, 3));
+        plain.measure(static_cast<double>(cloth.particles.size()), [&]
+                      { stepCloth(cloth.particles, cloth.constraints, multigrid); });
+        BenchContext fused(context.size, 1, std::min(context.repetitions, 3));
+        fused.measure(static_cast<double>(cloth.particles.size()), [&]
+                      {
+                          stepCloth(cloth.particles, cloth.constraints, multigrid, ring.beginFrame(cloth.particles.size()));
+                          ring.commitFrame(frame++);
+                      });
+        double plainNs = plain.result("").medianNs;
+        context.counter("fused_step", plainNs > 0.0 ? fused.result("").medianNs / plainNs : 0.0);
+    }
+
+    // one publishCloth, the copy out of the particle structs for a step that does not write the frame itself.
+    // vs_step is its median time over that of the step it follows, stepCloth with a ClothMultigrid as large cloths run
+    void publishCopy(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        FrameRingWriter ring;
+        if (!publishRing(context, cloth, ring))
+            return;
+        long long frame = 0;
+        context.measure(static_cast<double>(cloth.particles.size()), [&]
+                        { publishCloth(ring, frame++, cloth.particles, context.threads); });
+        context.counter("frame_mb", cloth.particles.size() * sizeof(Vec2) / 1e6);
+
+        ClothMultigrid multigrid(context.size, context.size);
+        BenchContext step(context.size, 1, std::min(context.repetitions, 3));
+        step.measure(static_cast<double>(cloth.particles.size()), [&]
+                     { stepCloth(cloth.particles, cloth.constraints, multigrid); });
+        double stepNs = step.result("").medianNs;
+        context.counter("vs_step", stepNs > 0.0 ? context.result("").medianNs / stepNs : 0.0);
+    }
+
+    // a 64 point zig-zag drag across the whole cloth; constraints are reactivated before each run
+    // so every run tests the same number of constraints
+    void tearPicking(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        const Vec2 topLeft = cloth.particles.front().position;
+        const Vec2 bottomRight = cloth.particles.back().position;
+        std::vector<Vec2> dragPath;
+        for (int i = 0; i < 64; ++i)
+        {
+            float t = i / 63.0f;
+            float wiggle = (i % 2) ? 0.05f : -0.05f;
+            dragPath.emplace_back(topLeft.x + (bottomRight.x - topLeft.x) * (t + wiggle),
+                                  topLeft.y + (bottomRight.y - topLeft.y) * t);
+        }
+
+        size_t torn = 0;
+        context.measure(static_cast<double>(cloth.constraints.size()), [&]
+                        {
+                            for (auto &constraint : cloth.constraints)
+                                constraint.isActive = true;
+                            processTear(dragPath, cloth.constraints, context.threads);
+                        });
+        for (const auto &constraint : cloth.constraints)
+            torn += constraint.isActive ? 0 : 1;
+        context.counter("torn", static_cast<double>(torn));
+    }
+
+    // clicks on the last particle, so the whole array is searched; toggled twice to leave the pin as it was
+    void pinPicking(BenchContext &context)
+    {
+        Cloth cloth(context.size);
+        Vec2 target = cloth.particles.back().position;
+        context.measure(2.0 * cloth.particles.size(), [&]
+                        {
+                            togglePin(target.x, target.y, cloth.particles, context.threads);
+                            togglePin(target.x, target.y, cloth.particles, context.threads);
+                        });
+    }
+}
+
+void registerClothBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    benchmarks.push_back({"cloth/constraint_satisfy", {30, 128, 512}, {1024}, false, constraintSatisfy});
+    // the two solvers over the same sizes, so every row of one has a row of the other to compare with
+    benchmarks.push_back({"cloth/relax_to_tolerance", {16, 30, 64}, {128}, false, relaxToTolerance});
+    benchmarks.push_back({"cloth/multigrid_to_tolerance", {16, 30, 64}, {128}, false, multigridToTolerance});
+    benchmarks.push_back({"cloth/relax_hanging", {16, 30, 64}, {128}, false, relaxHanging});
+    benchmarks.push_back({"cloth/multigrid_hanging", {16, 30, 64}, {128}, false, multigridHanging});
+    benchmarks.push_back({"cloth/particle_update", {30, 128, 512}, {1024}, true, particleUpdate});
+    benchmarks.push_back({"cloth/wind", {30, 128, 512}, {1024}, true, wind});
+    benchmarks.push_back({"cloth/step", {30, 128, 512}, {1024}, false, step});
+    benchmarks.push_back({"cloth/publish", {30, 128, 1024}, {}, true, publish});
+    benchmarks.push_back({"cloth/publish_copy", {30, 128, 1024}, {}, true, publishCopy});
+    benchmarks.push_back({"cloth/tear_picking", {30, 128, 512}, {1024}, true, tearPicking});
+    benchmarks.push_back({"cloth/pin_picking", {30, 128, 512}, {1024}, true, pinPicking});
+}
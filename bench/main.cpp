@@ -0,0 +1,236 @@
+#include "../common/parallel.hpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// unified benchmark suite for the hot kernels of every simulation
+//
+// ./bench                                  default sizes, 1 thread and all hardware threads, table on stdout
+// ./bench --filter cloth/ --threads 1,8    only names containing "cloth/", with 1 and 8 threads
+// ./bench --full --json results.json       larger sizes as well, results as JSON for the regression gate
+// ./bench --list                           benchmark names and sizes
+//
+// the JSON layout is stable: results are in registration order, then size, then threads, and every result has the
+// same fields in the same order. compare runs by (name, size, threads) and use median_ns.
+// a benchmark that could not run has its reason in "error" (null otherwise) and zero timings, and bench exits with 1
+
+BenchResult BenchContext::result(const std::string &name) const
+{
+    BenchResult result;
+    result.name = name;
+    result.size = size;
+    result.threads = threads;
+    result.repetitions = repetitions;
+    result.items = items;
+    result.counters = counters;
+    result.error = error;
+    if (error.empty() && !timings.empty())
+    {
+        std::vector<double> sorted = timings;
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        result.medianNs = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+        result.minNs = sorted.front();
+    }
+    return result;
+}
+
+namespace
+{
+    std::vector<int> parseList(const char *text)
+    {
+        std::vector<int> values;
+        for (const char *p = text; *p;)
+        {
+            values.push_back(std::atoi(p));
+            const char *comma = std::strchr(p, ',');
+            if (!comma)
+                break;
+            p = comma + 1;
+        }
+        return values;
+    }
+
+    std::string jsonEscape(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+        }
+        return escaped;
+    }
+
+    void writeJson(std::FILE *file, const std::vector<BenchResult> &results, int repetitions)
+    {
+        std::fprintf(file, "{\n");
+        std::fprintf(file, "  \"schema\": 2,\n");
+        std::fprintf(file, "  \"hardware_threads\": %d,\n", hardwareThreads());
+#if defined(__clang__)
+        std::fprintf(file, "  \"compiler\": \"clang %d.%d.%d\",\n", __clang_major__, __clang_minor__, __clang_patchlevel__);
+#elif defined(__GNUC__)
+        std::fprintf(file, "  \"compiler\": \"gcc %d.%d.%d\",\n", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+#else
+        std::fprintf(file, "  \"compiler\": \"unknown\",\n");
+#endif
+        std::fprintf(file, "  \"repetitions\": %d,\n", repetitions);
+        std::fprintf(file, "  \"results\": [");
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchResult &r = results[i];
+            double perItem = r.items > 0 ? r.medianNs / r.items : 0.0;
+            double perSecond = r.medianNs > 0 ? r.items * 1e9 / r.medianNs : 0.0;
+            std::fprintf(file, "%s\n    {\"name\": \"%s\", \"size\": %d, \"threads\": %d, \"items\": %.17g, "
+                               "\"median_ns\": %.6e, \"min_ns\": %.6e, \"ns_per_item\": %.6e, \"items_per_second\": %.6e",
+                         i ? "," : "", r.name.c_str(), r.size, r.threads, r.items, r.medianNs, r.minNs, perItem, perSecond);
+            std::fprintf(file, ", \"counters\": {");
+            for (size_t c = 0; c < r.counters.size(); ++c)
+                std::fprintf(file, "%s\"%s\": %.6e", c ? ", " : "", r.counters[c].first.c_str(), r.counters[c].second);
+            std::fprintf(file, "}");
+            if (r.error.empty())
+                std::fprintf(file, ", \"error\": null}");
+            else
+                std::fprintf(file, ", \"error\": \"%s\"}", jsonEscape(r.error).c_str());
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+    }
+
+    void printRow(const BenchResult &r)
+    {
+        if (!r.error.empty())
+        {
+            std::printf("%-32s %9d %7d  FAILED: %s\n", r.name.c_str(), r.size, r.threads, r.error.c_str());
+            return;
+        }
+        double perItem = r.items > 0 ? r.medianNs / r.items : 0.0;
+        std::printf("%-32s %9d %7d %14.3f %12.2f %14.4g", r.name.c_str(), r.size, r.threads, r.medianNs * 1e-6, perItem,
+                    r.medianNs > 0 ? r.items * 1e9 / r.medianNs : 0.0);
+        for (const auto &counter : r.counters)
+            std::printf("  %s=%.4g", counter.first.c_str(), counter.second);
+        std::printf("\n");
+    }
+
+    void printUsage()
+    {
+        std::fprintf(stderr, "usage: bench [--filter SUBSTRING] [--threads 1,4,...] [--repetitions N] [--full] [--json PATH|-] [--list]\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<Benchmark> benchmarks;
+    registerBallBenchmarks(benchmarks);
+    registerClothBenchmarks(benchmarks);
+    registerPendulumBenchmarks(benchmarks);
+    registerSnakeBenchmarks(benchmarks);
+#ifdef SIMULATIONS_RENDER_BENCH
+    registerRenderBenchmarks(benchmarks);
+#endif
+
+    std::string filter;
+    std::vector<int> threadCounts = {1, hardwareThreads()};
+    int repetitions = 5;
+    bool full = false;
+    bool list = false;
+    const char *jsonPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+            filter = argv[++i];
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+            threadCounts = parseList(argv[++i]);
+        else if (std::strcmp(argv[i], "--repetitions") == 0 && hasValue)
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+            jsonPath = argv[++i];
+        else if (std::strcmp(argv[i], "--full") == 0)
+            full = true;
+        else if (std::strcmp(argv[i], "--list") == 0)
+            list = true;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+    threadCounts.erase(std::remove_if(threadCounts.begin(), threadCounts.end(), [](int t)
+                                      { return t < 1; }),
+                       threadCounts.end());
+    if (threadCounts.empty())
+        threadCounts.push_back(1);
+
+    // with the JSON on stdout the table would corrupt it
+    bool table = !(jsonPath && std::strcmp(jsonPath, "-") == 0);
+    if (table && !list)
+        std::printf("%-32s %9s %7s %14s %12s %14s\n", "benchmark", "size", "threads", "median ms", "ns/item", "items/s");
+
+    std::vector<BenchResult> results;
+    bool failed = false;
+    for (const Benchmark &benchmark : benchmarks)
+    {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+            continue;
+
+        std::vector<int> sizes = benchmark.sizes;
+        if (full)
+            sizes.insert(sizes.end(), benchmark.fullSizes.begin(), benchmark.fullSizes.end());
+
+        if (list)
+        {
+            std::printf("%-32s", benchmark.name.c_str());
+            for (int size : sizes)
+                std::printf(" %d", size);
+            std::printf("%s\n", benchmark.threaded ? "" : "  (single threaded)");
+            continue;
+        }
+
+        for (int size : sizes)
+        {
+            for (int threads : threadCounts)
+            {
+                // single threaded benchmarks run once per size, whatever --threads asks for
+                if (!benchmark.threaded && threads != threadCounts.front())
+                    continue;
+                BenchContext context(size, benchmark.threaded ? threads : 1, repetitions);
+                benchmark.run(context);
+                results.push_back(context.result(benchmark.name));
+                if (!results.back().error.empty())
+                {
+                    std::fprintf(stderr, "%s (size %d, %d threads) failed: %s\n", benchmark.name.c_str(), size,
+                                 results.back().threads, results.back().error.c_str());
+                    failed = true;
+                }
+                if (table)
+                {
+                    printRow(results.back());
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+
+    if (jsonPath)
+    {
+        std::FILE *file = std::strcmp(jsonPath, "-") == 0 ? stdout : std::fopen(jsonPath, "w");
+        if (!file)
+        {
+            std::fprintf(stderr, "could not write %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(file, results, repetitions);
+        if (file != stdout)
+            std::fclose(file);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+#include "../pendulum/pendulum.hpp"
+#include "../common/parallel.hpp"
+#include "bench.hpp"
+
+// size is a number of independent pendulums, each started at a slightly different angle
+
+namespace
+{
+    std::vector<PendulumState> makeStates(int count)
+    {
+        std::vector<PendulumState> states(count);
+        for (int i = 0; i < count; ++i)
+        {
+            states[i].theta1 += 1e-3 * i / count;
+            states[i].theta2 -= 2e-3 * i / count;
+        }
+        return states;
+    }
+
+    // one viewer frame: 10 rk4 sub steps of dt 0.005 / 10
+    void rk4Step(BenchContext &context)
+    {
+        auto states = makeStates(context.size);
+        const int subSteps = 10;
+        context.measure(static_cast<double>(context.size) * subSteps, [&]
+                        { parallelFor(context.size, context.threads, [&](int begin, int end)
+                                      {
+                                          for (int i = begin; i < end; ++i)
+                                              step_pendulum(states[i], 0.005, subSteps);
+                                      }); });
+    }
+
+    // the equations of motion alone, rk4_step calls this four times
+    void derivativesKernel(BenchContext &context)
+    {
+        auto states = makeStates(context.size);
+        std::vector<double> omega1Dot(context.size), omega2Dot(context.size);
+        context.measure(static_cast<double>(context.size), [&]
+                        { parallelFor(context.size, context.threads, [&](int begin, int end)
+                                      {
+                                          for (int i = begin; i < end; ++i)
+                                          {
+                                              PendulumState &s = states[i];
+                                              derivatives(s.theta1, s.omega1, s.theta2, s.omega2, omega1Dot[i], omega2Dot[i]);
+                                          }
+                                      }); });
+    }
+}
+
+void registerPendulumBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    benchmarks.push_back({"pendulum/rk4_step", {1, 1000, 100000}, {1000000}, true, rk4Step});
+    benchmarks.push_back({"pendulum/derivatives", {1, 1000, 100000}, {1000000}, true, derivativesKernel});
+}
@@ -0,0 +1,175 @@
+#include "../renderer/renderer.hpp"
+#include "bench.hpp"
+#include <SFML/OpenGL.hpp>
+#include <cmath>
+#include <random>
+
+// frame time of the viewers' drawing, only built when SFML is found
+//
+// size is the number of objects on screen. every frame is drawn into an offscreen 800 x 600 render texture and
+// glFinish waits for the GPU, so the time covers building the vertices, the upload and the rasterization.
+// the render/*_draws benchmarks are the per object draw calls the viewers used before BatchRenderer, for comparison.
+// without an OpenGL context (a machine without a display) they fail instead of timing nothing
+
+namespace
+{
+    const unsigned TARGET_WIDTH = 800;
+    const unsigned TARGET_HEIGHT = 600;
+
+    bool makeTarget(BenchContext &context, sf::RenderTexture &target)
+    {
+        if (!target.create(TARGET_WIDTH, TARGET_HEIGHT))
+        {
+            context.fail("could not create an OpenGL render texture");
+            return false;
+        }
+        return true;
+    }
+
+    // waits until the GPU has drawn the frame, otherwise only the command submission is timed
+    void finish(sf::RenderTexture &target)
+    {
+        target.display();
+        if (target.setActive(true))
+            glFinish();
+    }
+
+    std::vector<sf::Vector2f> scatter(int count)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> x(0.0f, static_cast<float>(TARGET_WIDTH));
+        std::uniform_real_distribution<float> y(0.0f, static_cast<float>(TARGET_HEIGHT));
+        std::vector<sf::Vector2f> points(count);
+        for (auto &point : points)
+            point = sf::Vector2f(x(rng), y(rng));
+        return points;
+    }
+
+    // ball_in_box: one circle per ball
+    void circles(BenchContext &context)
+    {
+        sf::RenderTexture target;
+        if (!makeTarget(context, target))
+            return;
+        auto centers = scatter(context.size);
+        BatchRenderer renderer;
+        context.measure(context.size, [&]
+                        {
+                            target.clear(sf::Color::Black);
+                            renderer.begin();
+                            for (const auto &center : centers)
+                                renderer.circle(center, 2.0f, sf::Color::Red);
+                            renderer.flush(target);
+                            finish(target); });
+        context.counter("draw_calls", 1);
+    }
+
+    void circleDraws(BenchContext &context)
+    {
+        sf::RenderTexture target;
+        if (!makeTarget(context, target))
+            return;
+        auto centers = scatter(context.size);
+        sf::CircleShape shape(2.0f);
+        shape.setOrigin(2.0f, 2.0f);
+        shape.setFillColor(sf::Color::Red);
+        context.measure(context.size, [&]
+                        {
+                            target.clear(sf::Color::Black);
+                            for (const auto &center : centers)
+                            {
+                                shape.setPosition(center);
+                                target.draw(shape);
+                            }
+                            finish(target); });
+        context.counter("draw_calls", context.size);
+    }
+
+    // cloth: one line per constraint
+    void lines(BenchContext &context)
+    {
+        sf::RenderTexture target;
+        if (!makeTarget(context, target))
+            return;
+        auto ends = scatter(context.size + 1);
+        BatchRenderer renderer;
+        context.measure(context.size, [&]
+                        {
+                            target.clear(sf::Color::Black);
+                            renderer.begin();
+                            for (int i = 0; i < context.size; ++i)
+                                renderer.line(ends[i], ends[i] + sf::Vector2f(4.0f, 3.0f), sf::Color::White);
+                            renderer.flush(target);
+                            finish(target); });
+        context.counter("draw_calls", 1);
+    }
+
+    void lineDraws(BenchContext &context)
+    {
+        sf::RenderTexture target;
+        if (!makeTarget(context, target))
+            return;
+        auto ends = scatter(context.size + 1);
+        context.measure(context.size, [&]
+                        {
+                            target.clear(sf::Color::Black);
+                            for (int i = 0; i < context.size; ++i)
+                            {
+                                sf::Vertex line[] = {sf::Vertex(ends[i], sf::Color::White),
+                                                     sf::Vertex(ends[i] + sf::Vector2f(4.0f, 3.0f), sf::Color::White)};
+                                target.draw(line, 2, sf::Lines);
+                            }
+                            finish(target); });
+        context.counter("draw_calls", context.size);
+    }
+
+    // snake: one rotated quad per segment
+    void rotatedQuads(BenchContext &context)
+    {
+        sf::RenderTexture target;
+        if (!makeTarget(context, target))
+            return;
+        auto origins = scatter(context.size);
+        BatchRenderer renderer;
+        context.measure(context.size, [&]
+                        {
+                            target.clear(sf::Color::Black);
+                            renderer.begin();
+                            for (int i = 0; i < context.size; ++i)
+                                renderer.rotatedQuad(origins[i], sf::Vector2f(6.0f, 2.0f), 0.01f * i, sf::Color::Green);
+                            renderer.flush(target);
+                            finish(target); });
+        context.counter("draw_calls", 1);
+    }
+
+    void rectangleDraws(BenchContext &context)
+    {
+        sf::RenderTexture target;
+        if (!makeTarget(context, target))
+            return;
+        auto origins = scatter(context.size);
+        sf::RectangleShape shape(sf::Vector2f(6.0f, 2.0f));
+        shape.setFillColor(sf::Color::Green);
+        context.measure(context.size, [&]
+                        {
+                            target.clear(sf::Color::Black);
+                            for (int i = 0; i < context.size; ++i)
+                            {
+                                shape.setPosition(origins[i]);
+                                shape.setRotation(0.01f * i * 180.0f / 3.14159265f);
+                                target.draw(shape);
+                            }
+                            finish(target); });
+        context.counter("draw_calls", context.size);
+    }
+}
+
+void registerRenderBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    benchmarks.push_back({"render/circles", {1000, 10000, 100000}, {1000000}, false, circles});
+    benchmarks.push_back({"render/circle_draws", {1000, 10000, 100000}, {}, false, circleDraws});
+    benchmarks.push_back({"render/lines", {1000, 10000, 100000}, {1000000}, false, lines});
+    benchmarks.push_back({"render/line_draws", {1000, 10000, 100000}, {}, false, lineDraws});
+    benchmarks.push_back({"render/rotated_quads", {1000, 10000, 100000}, {1000000}, false, rotatedQuads});
+    benchmarks.push_back({"render/rectangle_draws", {1000, 10000, 100000}, {}, false, rectangleDraws});
+}
@@ -0,0 +1,54 @@
+#include "../snake/snake.hpp"
+#include "bench.hpp"
+
+// size is a number of snakes or chains, all with the demo's 10 segments of 20 px
+
+namespace
+{
+    const int JOINTS = 10;
+    const float SEGMENT_LENGTH = 20.f;
+
+    // Snake::update for independent snakes, each chasing its own point
+    void update(BenchContext &context)
+    {
+        std::vector<Snake> snakes(context.size, Snake(JOINTS, SEGMENT_LENGTH));
+        float time = 0.0f;
+        context.measure(static_cast<double>(context.size), [&]
+                        {
+                            time += 1.0f / 60.0f;
+                            parallelFor(context.size, context.threads, [&](int begin, int end)
+                                        {
+                                            for (int i = begin; i < end; ++i)
+                                                snakes[i].update(time, Vec2(400 + 100 * std::cos(time + i), 300 + 100 * std::sin(time + i)));
+                                        });
+                        });
+    }
+
+    // one frame of the tentacle demo: every target moves a little and the batch is solved from the last pose
+    void fabrik(BenchContext &context)
+    {
+        ChainBatch batch(context.size, JOINTS, SEGMENT_LENGTH);
+        for (int c = 0; c < context.size; ++c)
+            batch.setRoot(c, static_cast<float>(c % 1000), static_cast<float>(c / 1000) * 10.f);
+
+        float time = 0.0f;
+        long long iterations = 0, chainIterations = 0;
+        context.measure(static_cast<double>(context.size), [&]
+                        {
+                            time += 1.0f / 60.0f;
+                            moveTargets(batch, time, Vec2(500, 50), 90.f);
+                            batch.solve(context.threads);
+                            iterations += batch.lastIterations;
+                            chainIterations += batch.lastChainIterations;
+                        });
+        // iterations is the slowest chain, mean_iterations what a chain needs on average and so what the time follows
+        context.counter("iterations", static_cast<double>(iterations) / (context.repetitions + 1));
+        context.counter("mean_iterations", static_cast<double>(chainIterations) / context.size / (context.repetitions + 1));
+    }
+}
+
+void registerSnakeBenchmarks(std::vector<Benchmark> &benchmarks)
+{
+    benchmarks.push_back({"snake/update", {1, 1000, 100000}, {1000000}, true, update});
+    benchmarks.push_back({"snake/fabrik", {1000, 10000, 100000}, {1000000}, true, fabrik});
+}
@@ -0,0 +1,724 @@
+#include "cloth.hpp"
+
+void buildCloth(std::vector<Particle> &particles, std::vector<Constraint> &constraints, int rows, int cols)
+{
+    particles.clear();
+    constraints.clear();
+    // constraints point into particles, so it must not reallocate after the first constraint is made
+    particles.reserve(static_cast<size_t>(rows) * cols);
+    constraints.reserve(2 * static_cast<size_t>(rows) * cols);
+
+    // Create particles
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int col = 0; col < cols; ++col)
+        {
+            float x = col * REST_DISTANCE + WIDTH / 3.0f;
+            float y = row * REST_DISTANCE + 50.0f;                         // Start higher on the screen
+            bool pinned = (row == 0 && (col % 5 == 0 or col == cols - 1)); // Pin every 5th particle on the top row
+            particles.emplace_back(x, y, pinned);
+        }
+    }
+
+    // Create structural constraints (vertical and horizontal)
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int col = 0; col < cols; ++col)
+        {
+            int index = row * cols + col;
+            if (col < cols - 1)
+            {
+                constraints.emplace_back(&particles[index], &particles[index + 1]);
+            }
+            if (row < rows - 1)
+            {
+                constraints.emplace_back(&particles[index], &particles[index + cols]);
+            }
+        }
+    }
+
+    // // Create shear constraints (lower stiffness)
+    // for (int row = 0; row < rows - 1; ++row)
+    // {
+    //     for (int col = 0; col < cols - 1; ++col)
+    //     {
+    //         int index = row * cols + col;
+    //         constraints.emplace_back(&particles[index], &particles[index + cols + 1], shear_stiffness); // More flexible
+    //         constraints.emplace_back(&particles[index + 1], &particles[index + cols], shear_stiffness); // More flexible
+    //     }
+    // }
+
+    // // Create bend constraints (medium stiffness)
+    // for (int row = 0; row < rows; ++row)
+    // {
+    //     for (int col = 0; col < cols; ++col)
+    //     {
+    //         int index = row * cols + col;
+    //         if (col < cols - 2) // Horizontal bend constraint
+    //         {
+    //             constraints.emplace_back(&particles[index], &particles[index + 2], flexion_stiffness); // Moderate flexibility
+    //         }
+    //         if (row < rows - 2) // Vertical bend constraint
+    //         {
+    //             constraints.emplace_back(&particles[index], &particles[index + 2 * cols], flexion_stiffness); // Moderate flexibility
+    //         }
+    //     }
+    // }
+}
+
+void resetSimulation(std::vector<Particle> &particles, std::vector<Constraint> &constraints)
+{
+    buildCloth(particles, constraints, ROWS, COLS);
+}
+
+namespace
+{
+    // the first half of a step, everything but the constraints
+    void integrateParticles(std::vector<Particle> &particles)
+    {
+        // Update particles
+        // we are polling every single particle
+        // brute force
+        // note: look into
+        // 1) spatial partitioning (quadtree, octree, grid based methods)
+        // 2) broad phase and narrow phase collision detection
+        // 3) variable time stepping
+        // 4) parallelizaiton
+        // 5) reducing constraint equations dynamically
+        // 6) early exit constraint satisfaction
+        // 7) perhaps a larger rest distance
+        for (auto &particle : particles)
+        {
+            particle.applyForce(Vec2(0, GRAVITY));
+            particle.update(TIME_STEP);
+            particle.applyDamping(DAMPING);
+            particle.handleGroundCollision(HEIGHT - 1.0f); // Ground at bottom of the window
+        }
+    }
+
+    // a relaxation sweep that also writes both ends of every constraint into frame. a particle does not move after its
+    // last constraint, so its last write is its final position, and every particle of a buildCloth grid is the end of
+    // some constraint (torn ones stay in the list), so the frame comes out complete without a pass of its own
+    void satisfyIntoFrame(std::vector<Constraint> &constraints, const Particle *base, Vec2 *frame)
+    {
+        for (auto &constraint : constraints)
+        {
+            constraint.satisfy();
+            frame[constraint.particle1 - base] = constraint.particle1->position;
+            frame[constraint.particle2 - base] = constraint.particle2->position;
+        }
+    }
+}
+
+void stepCloth(std::vector<Particle> &particles, std::vector<Constraint> &constraints, Vec2 *frame)
+{
+    integrateParticles(particles);
+
+    // increasing makes more accurate, stiffer, and more stable but also increases computational cost
+    for (int i = 0; i < CONSTRAINT_ITERATIONS; ++i)
+    {
+        if (frame && i == CONSTRAINT_ITERATIONS - 1)
+        {
+            satisfyIntoFrame(constraints, particles.data(), frame);
+            break;
+        }
+        for (auto &constraint : constraints)
+        {
+            constraint.satisfy();
+        }
+    }
+}
+
+void stepCloth(std::vector<Particle> &particles, std::vector<Constraint> &constraints, ClothMultigrid &multigrid, Vec2 *frame)
+{
+    integrateParticles(particles);
+    multigrid.solve(particles, constraints, MULTIGRID_FINE_ITERATIONS, frame);
+}
+
+float maxStretch(const std::vector<Constraint> &constraints)
+{
+    float worst = 0.0f;
+    for (const auto &constraint : constraints)
+    {
+        if (!constraint.isActive)
+            continue;
+        Vec2 delta = constraint.particle2->position - constraint.particle1->position;
+        worst = std::max(worst, (std::hypot(delta.x, delta.y) - constraint.restLength) / constraint.restLength);
+    }
+    return worst;
+}
+
+// currently brute force
+// similar optimization like in processTear need to be implemented
+// with several threads each one finds the first hit in its chunk and the earliest chunk wins, same particle as serial
+void togglePin(float mouseX, float mouseY, std::vector<Particle> &particles, int threadCount)
+{
+    const float pinRadius = 10.0f; // 10 pixels
+    const float pinRadiusSq = pinRadius * pinRadius;
+
+    int count = static_cast<int>(particles.size());
+    threadCount = parallelThreadCount(count, threadCount, CHEAP_LOOP_GRAIN);
+    std::vector<int> firstHit(threadCount, -1);
+    int chunk = (count + threadCount - 1) / threadCount;
+
+    parallelFor(threadCount, threadCount, [&](int begin, int end)
+                {
+                    for (int t = begin; t < end; ++t)
+                    {
+                        for (int i = t * chunk; i < std::min(count, (t + 1) * chunk); ++i)
+                        {
+                            float dx = particles[i].position.x - mouseX;
+                            float dy = particles[i].position.y - mouseY;
+                            float distSq = dx * dx + dy * dy;
+                            if (distSq < pinRadiusSq)
+                            {
+                                firstHit[t] = i;
+                                break;
+                            }
+                        }
+                    }
+                });
+
+    for (int hit : firstHit)
+    {
+        if (hit >= 0)
+        {
+            particles[hit].isPinned = !particles[hit].isPinned;
+            break;
+        }
+    }
+}
+
+// currently implemented by brute force
+// note: look into
+// 1) spatial partitioning (quadtree, octree, grid based methods)
+// 2) sweep and prune
+// 3) bounding box pre-checks (aabb)
+// 4) early exit checks
+// 5) simplyfing the drag path maybe using Ramer-Douglas-Peucker algorithm
+// every constraint is tested on its own, so the constraints are simply split between threads
+void processTear(const std::vector<Vec2> &dragPath, std::vector<Constraint> &constraints, int threadCount)
+{
+    parallelFor(static_cast<int>(constraints.size()), threadCount, CHEAP_LOOP_GRAIN, [&](int begin, int end)
+                {
+                    for (int c = begin; c < end; ++c)
+                    {
+                        Constraint &constraint = constraints[c];
+                        if (!constraint.isActive)
+                            continue;
+                        for (size_t i = 0; i + 1 < dragPath.size(); ++i)
+                        {
+                            if (lineIntersectsLine(
+                                    dragPath[i], dragPath[i + 1],
+                                    constraint.particle1->position, constraint.particle2->position))
+                            {
+                                constraint.deactivate();
+                                break; // Move to next constraint after deactivation
+                            }
+                        }
+                    }
+                });
+}
+
+namespace
+{
+    // one edge of triangleWind, adds its inward push to (forceX, forceY)
+    inline void edgePressure(float edgeX, float edgeY, float side, float ux, float uy, float &forceX, float &forceY)
+    {
+        float nx = side * edgeY;
+        float ny = -side * edgeX;
+        float dot = ux * nx + uy * ny;
+        float facing = 0.5f * (dot - std::fabs(dot)); // min(dot, 0) without a branch
+        float weight = facing * facing / (edgeX * edgeX + edgeY * edgeY + 1e-12f);
+        forceX -= weight * nx;
+        forceY -= weight * ny;
+    }
+
+    // wind force on `count` triangles side by side in a row, vertex k of triangle t is at k[t] in the SoA arrays.
+    // a is the right angle corner, (a, b) and (c, a) are the structural edges, (b, c) is the diagonal inside the grid cell
+    // which the wind cannot hit. an intact structural edge whose outward normal faces the relative wind u is pushed
+    // inward by (u.n)^2 / |e|^2 * n; the normal is left unnormalized (|n| = |e|), so that is (u.n^)^2 |e| without a sqrt.
+    // abPressure and caPressure are k already divided by the number of such edges a line across the grid meets
+    void triangleWind(const float *__restrict ax, const float *__restrict ay, const float *__restrict avx, const float *__restrict avy,
+                      const float *__restrict bx, const float *__restrict by, const float *__restrict bvx, const float *__restrict bvy,
+                      const float *__restrict cx, const float *__restrict cy, const float *__restrict cvx, const float *__restrict cvy,
+                      const float *__restrict abOk, const float *__restrict caOk,
+                      float *__restrict outX, float *__restrict outY, int count,
+                      float windX, float windY, float abPressure, float caPressure, float drag, float lift)
+    {
+        for (int t = 0; t < count; ++t)
+        {
+            float ux = windX - (avx[t] + bvx[t] + cvx[t]) * (1.0f / 3.0f);
+            float uy = windY - (avy[t] + bvy[t] + cvy[t]) * (1.0f / 3.0f);
+
+            float abx = bx[t] - ax[t], aby = by[t] - ay[t];
+            float cax = ax[t] - cx[t], cay = ay[t] - cy[t];
+            // outward normals flip with the winding, so a folded over triangle (negative area) still has them pointing out
+            float side = std::copysign(1.0f, aby * cax - abx * cay);
+
+            float abForceX = 0.0f, abForceY = 0.0f, caForceX = 0.0f, caForceY = 0.0f;
+            edgePressure(abx, aby, side, ux, uy, abForceX, abForceY);
+            edgePressure(cax, cay, side, ux, uy, caForceX, caForceY);
+            float px = abPressure * abOk[t] * abForceX + caPressure * caOk[t] * caForceX;
+            float py = abPressure * abOk[t] * abForceY + caPressure * caOk[t] * caForceY;
+
+            float along = (px * ux + py * uy) / (ux * ux + uy * uy + 1e-12f);
+            float dragX = along * ux, dragY = along * uy;
+            outX[t] = drag * dragX + lift * (px - dragX);
+            outY[t] = drag * dragY + lift * (py - dragY);
+        }
+    }
+
+    // a third of the force of every triangle particle p is a corner of, see ClothWind::apply
+    void gatherCorners(const float *__restrict lower, const float *__restrict upper, float *__restrict force, int begin, int end, int cols)
+    {
+        for (int p = begin; p < end; ++p)
+            force[p] = (lower[p] + lower[p - 1] + lower[p - cols] + upper[p - 1] + upper[p - cols - 1] + upper[p - cols]) * (1.0f / 3.0f);
+    }
+}
+
+void ClothWind::apply(std::vector<Particle> &particles, const std::vector<Constraint> &constraints, int threadCount)
+{
+    const int n = rows * cols;
+    const int pad = cols + 1; // triangle arrays start with a row of zeros so the gather never reads out of bounds
+    if (static_cast<int>(particles.size()) != n || rows < 2 || cols < 2)
+        return;
+    // four passes each start their own threads, the grain keeps the viewer's 900 particles on one
+    const int rowGrain = std::max(1, CHEAP_LOOP_GRAIN / cols);
+    if (static_cast<int>(px.size()) != n)
+    {
+        px.assign(n, 0.0f);
+        py.assign(n, 0.0f);
+        vx.assign(n, 0.0f);
+        vy.assign(n, 0.0f);
+        horizontalOk.assign(n, 0.0f);
+        verticalOk.assign(n, 0.0f);
+        forceX.assign(n, 0.0f);
+        forceY.assign(n, 0.0f);
+        // entries of the last column and row are never written, they stay zero
+        lowerX.assign(n + pad, 0.0f);
+        lowerY.assign(n + pad, 0.0f);
+        upperX.assign(n + pad, 0.0f);
+        upperY.assign(n + pad, 0.0f);
+    }
+
+    parallelFor(n, threadCount, CHEAP_LOOP_GRAIN, [&](int begin, int end)
+                {
+                    for (int i = begin; i < end; ++i)
+                    {
+                        const Particle &particle = particles[i];
+                        px[i] = particle.position.x;
+                        py[i] = particle.position.y;
+                        vx[i] = (particle.position.x - particle.previousPosition.x) / TIME_STEP;
+                        vy[i] = (particle.position.y - particle.previousPosition.y) / TIME_STEP;
+                        horizontalOk[i] = 0.0f;
+                        verticalOk[i] = 0.0f;
+                    }
+                });
+
+    // every edge is one constraint, so each flag is written by exactly one iteration
+    const Particle *base = particles.data();
+    parallelFor(static_cast<int>(constraints.size()), threadCount, CHEAP_LOOP_GRAIN, [&](int begin, int end)
+                {
+                    for (int c = begin; c < end; ++c)
+                    {
+                        int a = static_cast<int>(constraints[c].particle1 - base);
+                        int b = static_cast<int>(constraints[c].particle2 - base);
+                        int first = std::min(a, b);
+                        float ok = constraints[c].isActive ? 1.0f : 0.0f;
+                        if (std::max(a, b) == first + 1)
+                            horizontalOk[first] = ok;
+                        else if (std::max(a, b) == first + cols)
+                            verticalOk[first] = ok;
+                    }
+                });
+
+    // a line across the grid meets rows - 1 horizontal and cols - 1 vertical edges that all face the same way, so
+    // without this the force of a flat cloth would grow with its resolution instead of with its size
+    const float horizontalPressure = pressure / (rows - 1);
+    const float verticalPressure = pressure / (cols - 1);
+    parallelFor(rows - 1, threadCount, rowGrain, [&](int begin, int end)
+                {
+                    for (int row = begin; row < end; ++row)
+                    {
+                        int i = row * cols;
+                        int j = i + 1;
+                        int k = i + cols;
+                        int l = i + cols + 1;
+                        // lower triangle (i, i + 1, i + cols), right angle at i
+                        triangleWind(&px[i], &py[i], &vx[i], &vy[i], &px[j], &py[j], &vx[j], &vy[j], &px[k], &py[k], &vx[k], &vy[k],
+                                     &horizontalOk[i], &verticalOk[i], &lowerX[pad + i], &lowerY[pad + i], cols - 1,
+                                     velocity.x, velocity.y, horizontalPressure, verticalPressure, dragCoefficient, liftCoefficient);
+                        // upper triangle, the same corners in the order (i + cols + 1, i + cols, i + 1), right angle at i + cols + 1
+                        triangleWind(&px[l], &py[l], &vx[l], &vy[l], &px[k], &py[k], &vx[k], &vy[k], &px[j], &py[j], &vx[j], &vy[j],
+                                     &horizontalOk[k], &verticalOk[j], &upperX[pad + i], &upperY[pad + i], cols - 1,
+                                     velocity.x, velocity.y, horizontalPressure, verticalPressure, dragCoefficient, liftCoefficient);
+                    }
+                });
+
+    // particle p is a corner of the lower triangles of cells p, p - 1, p - cols and the upper triangles of cells
+    // p - 1, p - cols - 1, p - cols; cells that do not exist read zeros
+    parallelFor(n, threadCount, CHEAP_LOOP_GRAIN, [&](int begin, int end)
+                {
+                    gatherCorners(lowerX.data() + pad, upperX.data() + pad, forceX.data(), begin, end, cols);
+                    gatherCorners(lowerY.data() + pad, upperY.data() + pad, forceY.data(), begin, end, cols);
+                    for (int p = begin; p < end; ++p)
+                        particles[p].applyForce(Vec2(forceX[p], forceY[p]));
+                });
+}
+
+namespace
+{
+    // rows or columns kept by the next coarser level: every other one and the last, as long as more than 3 are left
+    std::vector<int> coarsen(int count)
+    {
+        std::vector<int> kept;
+        for (int i = 0; i < count; i += (count > 3 ? 2 : 1))
+            kept.push_back(i);
+        if (kept.back() != count - 1)
+            kept.push_back(count - 1);
+        return kept;
+    }
+
+    // for every finer row (or column) the coarse cell it lies in and its weight in there
+    void cellWeights(const std::vector<int> &kept, int fineCount, std::vector<int> &cell, std::vector<float> &weight)
+    {
+        cell.assign(fineCount, 0);
+        weight.assign(fineCount, 0.0f);
+        int k = 0;
+        for (int p = 0; p < fineCount; ++p)
+        {
+            while (k + 2 < static_cast<int>(kept.size()) && kept[k + 1] <= p)
+                ++k;
+            cell[p] = k;
+            weight[p] = static_cast<float>(p - kept[k]) / (kept[k + 1] - kept[k]);
+        }
+    }
+
+    // a coarse edge only pulls its ends together, pinned ends stay and leave the whole correction to the other one
+    inline void limitStretch(Vec2 &a, Vec2 &b, bool pinnedA, bool pinnedB, float rest)
+    {
+        Vec2 delta = b - a;
+        float lengthSq = delta.x * delta.x + delta.y * delta.y;
+        if (lengthSq <= rest * rest || (pinnedA && pinnedB))
+            return;
+        float length = std::sqrt(lengthSq);
+        Vec2 correction = delta * ((length - rest) / (length * ((pinnedA ? 0.0f : 1.0f) + (pinnedB ? 0.0f : 1.0f))));
+        if (!pinnedA)
+            a += correction;
+        if (!pinnedB)
+            b -= correction;
+    }
+}
+
+ClothMultigrid::ClothMultigrid(int rows, int cols) : rows(rows), cols(cols)
+{
+    if (rows < 2 || cols < 2)
+        return;
+    Level fine;
+    fine.rows = rows;
+    fine.cols = cols;
+    levels.push_back(fine);
+    while (levels.back().rows > 3 || levels.back().cols > 3)
+    {
+        const Level &finer = levels.back();
+        Level coarse;
+        coarse.rowPosition = coarsen(finer.rows);
+        coarse.colPosition = coarsen(finer.cols);
+        coarse.rows = static_cast<int>(coarse.rowPosition.size());
+        coarse.cols = static_cast<int>(coarse.colPosition.size());
+        cellWeights(coarse.rowPosition, finer.rows, coarse.rowCell, coarse.rowWeight);
+        cellWeights(coarse.colPosition, finer.cols, coarse.colCell, coarse.colWeight);
+        levels.push_back(std::move(coarse));
+    }
+
+    for (Level &level : levels)
+    {
+        size_t n = static_cast<size_t>(level.rows) * level.cols;
+        level.horizontalRest.assign(n, 0.0f);
+        level.verticalRest.assign(n, 0.0f);
+        level.cellOk.assign(n, 0);
+        level.pinned.assign(n, 0);
+        level.start.assign(n, Vec2(0, 0));
+        if (&level != &levels[0])
+            level.position.assign(n, Vec2(0, 0));
+    }
+}
+
+void ClothMultigrid::solve(std::vector<Particle> &particles, std::vector<Constraint> &constraints, int fineIterations, Vec2 *frame)
+{
+    const int n = rows * cols;
+    if (levels.size() > 1 && static_cast<int>(particles.size()) == n)
+    {
+        // the finest level is read straight off the particles and constraints
+        Level &fine = levels[0];
+        for (int i = 0; i < n; ++i)
+        {
+            fine.start[i] = particles[i].position;
+            fine.pinned[i] = particles[i].isPinned ? 1 : 0;
+            fine.horizontalRest[i] = 0.0f;
+            fine.verticalRest[i] = 0.0f;
+        }
+        const Particle *base = particles.data();
+        for (const auto &constraint : constraints)
+        {
+            int a = static_cast<int>(constraint.particle1 - base);
+            int b = static_cast<int>(constraint.particle2 - base);
+            int first = std::min(a, b);
+            float rest = constraint.isActive ? constraint.restLength : 0.0f;
+            if (std::max(a, b) == first + 1)
+                fine.horizontalRest[first] = rest;
+            else if (std::max(a, b) == first + cols)
+                fine.verticalRest[first] = rest;
+        }
+        for (int row = 0; row + 1 < rows; ++row)
+        {
+            for (int col = 0; col + 1 < cols; ++col)
+            {
+                int i = row * cols + col;
+                fine.cellOk[i] = fine.horizontalRest[i] > 0.0f && fine.horizontalRest[i + cols] > 0.0f &&
+                                 fine.verticalRest[i] > 0.0f && fine.verticalRest[i + 1] > 0.0f;
+            }
+        }
+
+        for (size_t l = 1; l < levels.size(); ++l)
+            inject(levels[l - 1], levels[l]);
+        for (size_t l = levels.size() - 1; l > 0; --l)
+        {
+            relax(levels[l]);
+            prolong(levels[l], levels[l - 1], l == 1 ? particles.data() : nullptr);
+        }
+    }
+
+    for (int i = 0; i < fineIterations; ++i)
+    {
+        if (frame && i == fineIterations - 1)
+        {
+            satisfyIntoFrame(constraints, particles.data(), frame);
+            break;
+        }
+        for (auto &constraint : constraints)
+            constraint.satisfy();
+    }
+}
+
+void ClothMultigrid::inject(const Level &fine, Level &coarse)
+{
+    for (int i = 0; i < coarse.rows; ++i)
+    {
+        for (int j = 0; j < coarse.cols; ++j)
+        {
+            int c = i * coarse.cols + j;
+            int row = coarse.rowPosition[i];
+            int col = coarse.colPosition[j];
+            coarse.start[c] = fine.start[row * fine.cols + col];
+            coarse.position[c] = coarse.start[c];
+            coarse.pinned[c] = fine.pinned[row * fine.cols + col];
+
+            int nextRow = i + 1 < coarse.rows ? coarse.rowPosition[i + 1] : row;
+            int nextCol = j + 1 < coarse.cols ? coarse.colPosition[j + 1] : col;
+            // a span with one torn (zero) edge makes the product zero
+            float horizontal = 0.0f, vertical = 0.0f, horizontalIntact = 1.0f, verticalIntact = 1.0f;
+            for (int q = col; q < nextCol; ++q)
+            {
+                horizontal += fine.horizontalRest[row * fine.cols + q];
+                horizontalIntact *= fine.horizontalRest[row * fine.cols + q] > 0.0f ? 1.0f : 0.0f;
+            }
+            for (int p = row; p < nextRow; ++p)
+            {
+                vertical += fine.verticalRest[p * fine.cols + col];
+                verticalIntact *= fine.verticalRest[p * fine.cols + col] > 0.0f ? 1.0f : 0.0f;
+            }
+            coarse.horizontalRest[c] = horizontal * horizontalIntact;
+            coarse.verticalRest[c] = vertical * verticalIntact;
+
+            uint8_t ok = nextRow > row && nextCol > col;
+            for (int p = row; p < nextRow; ++p)
+                for (int q = col; q < nextCol; ++q)
+                    ok &= fine.cellOk[p * fine.cols + q];
+            coarse.cellOk[c] = ok;
+        }
+    }
+}
+
+// gauss-seidel in the order buildCloth creates the constraints
+void ClothMultigrid::relax(Level &level)
+{
+    for (int iteration = 0; iteration < coarseIterations; ++iteration)
+    {
+        for (int i = 0; i < level.rows; ++i)
+        {
+            for (int j = 0; j < level.cols; ++j)
+            {
+                int c = i * level.cols + j;
+                if (level.horizontalRest[c] > 0.0f)
+                    limitStretch(level.position[c], level.position[c + 1], level.pinned[c], level.pinned[c + 1], level.horizontalRest[c]);
+                if (level.verticalRest[c] > 0.0f)
+                    limitStretch(level.position[c], level.position[c + level.cols], level.pinned[c], level.pinned[c + level.cols], level.verticalRest[c]);
+            }
+        }
+    }
+}
+
+// nodes the coarse level kept take its position, the others their start plus the bilinear blend of the
+// displacements of the coarse cell's corners; particles is set when the finer level is the cloth itself
+void ClothMultigrid::prolong(const Level &coarse, Level &fine, Particle *particles)
+{
+    for (int row = 0; row < fine.rows; ++row)
+    {
+        int k = coarse.rowCell[row];
+        float t = coarse.rowWeight[row];
+        for (int col = 0; col < fine.cols; ++col)
+        {
+            int f = row * fine.cols + col;
+            int m = coarse.colCell[col];
+            float u = coarse.colWeight[col];
+            int c = k * coarse.cols + m;
+            if (fine.pinned[f] || (!coarse.cellOk[c] && (t > 0.0f || u > 0.0f)))
+                continue;
+
+            Vec2 d00 = coarse.position[c] - coarse.start[c];
+            Vec2 d01 = coarse.position[c + 1] - coarse.start[c + 1];
+            Vec2 d10 = coarse.position[c + coarse.cols] - coarse.start[c + coarse.cols];
+            Vec2 d11 = coarse.position[c + coarse.cols + 1] - coarse.start[c + coarse.cols + 1];
+            Vec2 target = fine.start[f] + (d00 * (1.0f - u) + d01 * u) * (1.0f - t) + (d10 * (1.0f - u) + d11 * u) * t;
+            if (particles)
+                particles[f].position = target;
+            else
+                fine.position[f] = target;
+        }
+    }
+}
+
+namespace
+{
+    // Particle's fields with its three padding bytes spelled out and zeroed, so snapshots of equal cloths are equal
+    // byte for byte. same size and offsets as Particle
+    struct ParticleRecord
+    {
+        Vec2 position;
+        Vec2 previousPosition;
+        Vec2 acceleration;
+        uint8_t isPinned;
+        uint8_t unused[3];
+    };
+
+    struct ConstraintRecord
+    {
+        int32_t particle1, particle2;
+        float restLength;
+        float stiffness;
+    };
+}
+
+void saveCloth(SnapshotWriter &writer, const std::vector<Particle> &particles, const std::vector<Constraint> &constraints)
+{
+    std::vector<ParticleRecord> particleRecords;
+    particleRecords.reserve(particles.size());
+    for (const auto &particle : particles)
+        particleRecords.push_back({particle.position, particle.previousPosition, particle.acceleration,
+                                   static_cast<uint8_t>(particle.isPinned ? 1 : 0), {0, 0, 0}});
+
+    std::vector<ConstraintRecord> records;
+    std::vector<uint8_t> active;
+    records.reserve(constraints.size());
+    active.reserve(constraints.size());
+    for (const auto &constraint : constraints)
+    {
+        records.push_back({static_cast<int32_t>(constraint.particle1 - particles.data()),
+                           static_cast<int32_t>(constraint.particle2 - particles.data()),
+                           constraint.restLength, constraint.stiffness});
+        active.push_back(constraint.isActive ? 1 : 0);
+    }
+    writer.array("particle", particleRecords);
+    writer.array("links", records);
+    writer.array("active", active);
+}
+
+bool loadCloth(SnapshotReader &reader, std::vector<Particle> &particles, std::vector<Constraint> &constraints)
+{
+    size_t particleCount, constraintCount, activeCount;
+    const ParticleRecord *savedParticles = reader.array<ParticleRecord>("particle", particleCount);
+    const ConstraintRecord *records = reader.array<ConstraintRecord>("links", constraintCount);
+    const uint8_t *active = reader.array<uint8_t>("active", activeCount);
+    if (!reader.ok() || activeCount != constraintCount)
+        return false;
+    for (size_t c = 0; c < constraintCount; ++c)
+    {
+        if (records[c].particle1 < 0 || records[c].particle2 < 0 ||
+            static_cast<size_t>(std::max(records[c].particle1, records[c].particle2)) >= particleCount)
+            return false;
+    }
+
+    particles.clear();
+    particles.reserve(particleCount);
+    for (size_t i = 0; i < particleCount; ++i)
+    {
+        const ParticleRecord &record = savedParticles[i];
+        particles.emplace_back(record.position.x, record.position.y, record.isPinned != 0);
+        particles.back().previousPosition = record.previousPosition;
+        particles.back().acceleration = record.acceleration;
+    }
+    constraints.clear();
+    constraints.reserve(constraintCount);
+    for (size_t c = 0; c < constraintCount; ++c)
+    {
+        constraints.emplace_back(&particles[records[c].particle1], &particles[records[c].particle2], records[c].stiffness);
+        // the constructor measures the current distance, the saved rest length is the one the cloth was built with
+        constraints.back().restLength = records[c].restLength;
+        constraints.back().isActive = active[c] != 0;
+    }
+    return true;
+}
+
+// a bandwidth bound gather out of the particle structs, threads help once the cloth no longer fits in cache
+void publishCloth(FrameRingWriter &ring, long long step, const std::vector<Particle> &particles, int threadCount)
+{
+    int count = static_cast<int>(particles.size());
+    ring.publish(step, particles.size(), [&](Vec2 *positions)
+                 { parallelFor(count, threadCount, CHEAP_LOOP_GRAIN, [&](int begin, int end)
+                               {
+                                   for (int i = begin; i < end; ++i)
+                                       positions[i] = particles[i].position;
+                               }); });
+}
+
+void publishClothFlags(FrameRingWriter &ring, const std::vector<Particle> &particles, const std::vector<Constraint> &constraints, int cols)
+{
+    std::vector<uint8_t> flags(particles.size(), 0);
+    for (size_t i = 0; i < particles.size(); ++i)
+        flags[i] = particles[i].isPinned ? CLOTH_FLAG_PINNED : 0;
+    const Particle *base = particles.data();
+    for (const auto &constraint : constraints)
+    {
+        if (!constraint.isActive)
+            continue;
+        int a = static_cast<int>(constraint.particle1 - base);
+        int b = static_cast<int>(constraint.particle2 - base);
+        int first = std::min(a, b);
+        if (std::max(a, b) == first + 1)
+            flags[first] |= CLOTH_FLAG_RIGHT;
+        else if (std::max(a, b) == first + cols)
+            flags[first] |= CLOTH_FLAG_DOWN;
+    }
+    ring.publishFlags(flags.data(), flags.size());
+}
+
+// using Parametric Line Intersection
+// determines if two lines intersection in a 2D space
+bool lineIntersectsLine(const Vec2 &a1, const Vec2 &a2,
+                        const Vec2 &b1, const Vec2 &b2)
+{
+
+    // a1 a2 are the end points of the first line segment, b1 and b2 of the second line segment
+
+    // calculate the determinant
+    float d = (a2.x - a1.x) * (b2.y - b1.y) - (a2.y - a1.y) * (b2.x - b1.x);
+    if (d == 0.0f)
+        return false;
+
+    float ua = ((b2.x - b1.x) * (a1.y - b1.y) - (b2.y - b1.y) * (a1.x - b1.x)) / d;
+    float ub = ((a2.x - a1.x) * (a1.y - b1.y) - (a2.y - a1.y) * (a1.x - b1.x)) / d;
+
+    return (ua >= 0.0f && ua <= 1.0f && ub >= 0.0f && ub <= 1.0f);
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "../common/frame_ring.hpp"
+#include "../common/parallel.hpp"
+#include "../common/snapshot.hpp"
+#include "../common/vec2.hpp"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+// cloth physics, no SFML in here so it can be used by the viewer, the headless runner and the benchmarks
+
+// assuming 100 pixels represent 1 meter, hence gravity is 980
+
+class Particle
+{
+public:
+    Vec2 position;
+    Vec2 previousPosition;
+    Vec2 acceleration;
+    bool isPinned;
+
+    // verlet integration is used, hence the next position is a function of the previous position, current position and the acceleration
+    // "pin" a particle to make its position fixed
+
+    Particle(float x, float y, bool pinned = false)
+        : position(x, y), previousPosition(x, y), acceleration(0, 0), isPinned(pinned) {}
+
+    // since all "particles" have the same mass, you assume some arbitrary unit mass (as its the interaction between them that is of interest)
+
+    void applyForce(const Vec2 &force)
+    {
+        if (!isPinned)
+        {
+            acceleration += force;
+        }
+    }
+
+    void update(float timeStep)
+    {
+        if (!isPinned)
+        {
+            Vec2 velocity = position - previousPosition;
+            previousPosition = position;
+            position += velocity + acceleration * timeStep * timeStep;
+            acceleration = Vec2(0, 0); // Reset acceleration after update
+        }
+        else
+        {
+            previousPosition = position;
+        }
+    }
+
+    void constrainToBounds(float width, float height)
+    {
+        if (position.x < 0.0f)
+            position.x = 0.0f;
+        if (position.x > width)
+            position.x = width;
+        if (position.y < 0.0f)
+            position.y = 0.0f;
+        if (position.y > height - 1.0f)
+            position.y = height - 1.0f;
+    }
+
+    // damping simulates energy loss
+    void applyDamping(float damping)
+    {
+        if (!isPinned)
+        {
+            Vec2 velocity = position - previousPosition;
+            velocity *= damping;
+            previousPosition = position - velocity;
+        }
+    }
+
+    void handleGroundCollision(float groundY)
+    {
+        if (position.y > groundY)
+        {
+            position.y = groundY;
+            if (!isPinned)
+            {
+                Vec2 velocity = position - previousPosition;
+                velocity.y *= -0.5f; // Bounce effect with damping
+                previousPosition.y = position.y - velocity.y;
+            }
+        }
+    }
+};
+
+// shear sprinsg (i,j) and (i+1, j+1)
+// flexion springs (i,j) - (i+2, j) and (i,j+2)
+
+class Constraint
+{
+    // implement the structural forces using constraints
+public:
+    Particle *particle1;
+    Particle *particle2;
+    float restLength;
+    // make inactive if the constraint is broken
+    bool isActive;
+    float stiffness;
+
+    // calculate the rest length between the two particles
+    Constraint(Particle *p1, Particle *p2, float stiffness = 1.0f)
+        : particle1(p1), particle2(p2), isActive(true), stiffness(stiffness)
+    {
+        Vec2 delta = particle2->position - particle1->position;
+        restLength = std::hypot(delta.x, delta.y);
+    }
+
+    // method is based on verlet integration and constraint relaxation
+
+    // constraint projection is the key idea, instead of applying the forces, we directly use the positions of the particles to satisfy the constraints
+    // this makes the method more stable
+
+    // taken from the paper "Advanced Character Physics" by Thomas Jakobsen (specifically the function void ParticleSystem::SatisfyConstraints())
+
+    // note: can optimize to approximate the square root which hasn't been implemented
+    void satisfy()
+    {
+        if (!isActive)
+            return;
+
+        Vec2 delta = particle2->position - particle1->position;
+        float currentLength = std::hypot(delta.x, delta.y);
+
+        // normalize the difference with the current length
+        float diff = (currentLength - restLength) / currentLength;
+
+        // scale the distance between them based on the difference, and multiply by 0.5 so that the correction is equally shared between the two particles
+        Vec2 correction = delta * 0.5f * diff * stiffness;
+
+        if (!particle1->isPinned)
+            particle1->position += correction;
+        if (!particle2->isPinned)
+            particle2->position -= correction;
+    }
+
+    void deactivate() { isActive = false; }
+};
+
+// wind drag and lift on the triangles of a rows x cols cloth made by buildCloth, added as forces before stepCloth
+//
+// every grid cell (i, i + 1, i + cols, i + cols + 1) is split into two right triangles, (i, i + 1, i + cols) and
+// (i + cols + 1, i + cols, i + 1). the cloth lives in the screen plane, so the surface a triangle shows to the in-plane
+// wind is its boundary: each of its two structural edges that faces the relative wind u (and is not torn) gets a
+// pressure k (u.n)^2 |e| along its inward normal (Newtonian flat plate), and the triangle's total is split into the
+// part along u (drag) and across it (lift). an undeformed cloth only feels drag, lift appears where cells shear or turn.
+// every row of cells has an edge facing a sideways wind, not just the outline, so a horizontal edge's k is divided by
+// rows - 1 and a vertical edge's by cols - 1: the wind load then depends on the cloth's size, not on how finely it is
+// split, and the force is still spread over every cell rather than piled onto the windward edge
+//
+// done in four conflict-free passes: particles to SoA positions and velocities, intact edge flags from the constraints,
+// one force per triangle, then every particle gathers a third of the force of its (up to six) triangles.
+// the triangle and gather passes are plain loops over consecutive SoA floats with no branches and no sqrt, so the
+// compiler vectorizes them (build with -O3, like ChainBatch)
+class ClothWind
+{
+public:
+    Vec2 velocity = Vec2(0, 0);   // wind, pixels per second
+    float pressure = 5.8e-3f;     // k above, air density folded in
+    float dragCoefficient = 1.0f; // scales the force along the relative wind
+    float liftCoefficient = 1.0f; // scales the force across it
+
+    ClothWind(int rows, int cols) : rows(rows), cols(cols) {}
+
+    // adds the wind force of this step to every unpinned particle's acceleration
+    void apply(std::vector<Particle> &particles, const std::vector<Constraint> &constraints, int threadCount = 1);
+
+private:
+    int rows, cols;
+    std::vector<float> px, py, vx, vy;          // particle positions and velocities
+    std::vector<float> horizontalOk, verticalOk; // 1 if the edge from particle i to i + 1 / i + cols is intact
+    std::vector<float> lowerX, lowerY;          // force on triangle (i, i + 1, i + cols), offset by cols + 1
+    std::vector<float> upperX, upperY;          // force on triangle (i + cols + 1, i + cols, i + 1), offset by cols + 1
+    std::vector<float> forceX, forceY;          // gathered force on every particle
+};
+
+// hierarchical constraint solve for large rows x cols cloths made by buildCloth
+//
+// a relaxation sweep only moves an error one constraint further, so a tall cloth needs about as many sweeps as it has
+// rows before its bottom hears of the pins. the solver keeps coarser copies of the grid, level l + 1 takes every other
+// row and column of level l (the last row and column are always kept), down to a few nodes a side.
+// restriction is injection: a coarse node starts at its fine particle's position and keeps its pin, a coarse edge's
+// rest length is the sum of the fine rest lengths it spans and it is torn if any of them is.
+// a cycle relaxes the coarsest level, prolongs its correction (coarse node displacement, bilinear inside the coarse
+// cell) to the next finer level, relaxes that one and so on, and ends with ordinary Constraint::satisfy sweeps.
+// coarse edges only resist stretching, a coarse straight line cannot tell a fold from a compression
+// (see "Hierarchical Position Based Dynamics", Mueller 2008). cells with a torn edge inside do not pass corrections on,
+// so the two sides of a tear stay independent
+class ClothMultigrid
+{
+public:
+    int coarseIterations = 2; // relaxation sweeps of every coarse level per cycle
+
+    ClothMultigrid(int rows, int cols);
+
+    // one cycle, then fineIterations sweeps over the constraints in creation order like stepCloth (frame as there)
+    void solve(std::vector<Particle> &particles, std::vector<Constraint> &constraints, int fineIterations, Vec2 *frame = nullptr);
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+
+private:
+    struct Level
+    {
+        int rows, cols;
+        std::vector<int> rowPosition, colPosition; // row / column of the finer level each row / column is taken from
+        std::vector<int> rowCell, colCell;         // for every finer row / column, the coarse cell it lies in
+        std::vector<float> rowWeight, colWeight;   // and how far into it, 0 on the cell's first row / column
+        std::vector<float> horizontalRest;         // node (i, j) to (i, j + 1), 0 if torn or not there
+        std::vector<float> verticalRest;           // node (i, j) to (i + 1, j)
+        std::vector<uint8_t> cellOk;               // 1 if no edge inside cell (i, j) is torn
+        std::vector<uint8_t> pinned;
+        std::vector<Vec2> start, position; // positions before the cycle and now
+    };
+
+    int rows, cols;
+    std::vector<Level> levels; // levels[0] is the cloth itself, its positions stay in the particles
+
+    void inject(const Level &fine, Level &coarse);
+    void relax(Level &level);
+    void prolong(const Level &coarse, Level &fine, Particle *particles);
+};
+
+const int WIDTH = 1080;
+const int HEIGHT = 640;
+const float GRAVITY = 980.0f;   // Adjusted gravity
+const float TIME_STEP = 0.016f; // 60 FPS, the physics updates 60 times per second
+const float DAMPING = 0.99f;    // reducing damping will make it more bouncy and less resistant to movement
+const int ROWS = 30;
+const int COLS = 30;
+const float REST_DISTANCE = 10.0f;
+const int CONSTRAINT_ITERATIONS = 15;
+const int MULTIGRID_FINE_ITERATIONS = 4; // fine sweeps after each multigrid cycle
+
+// builds a rows x cols grid of particles and its structural constraints, pinned along the top row
+void buildCloth(std::vector<Particle> &particles, std::vector<Constraint> &constraints, int rows, int cols);
+
+// the ROWS x COLS cloth of the viewer
+void resetSimulation(std::vector<Particle> &particles, std::vector<Constraint> &constraints);
+
+// one fixed TIME_STEP: forces, verlet, damping, ground, then CONSTRAINT_ITERATIONS relaxation sweeps.
+// with a frame (FrameRingWriter::beginFrame) the last sweep also writes every particle's final position into it,
+// for cloths made by buildCloth
+void stepCloth(std::vector<Particle> &particles, std::vector<Constraint> &constraints, Vec2 *frame = nullptr);
+
+// the same step with one multigrid cycle and MULTIGRID_FINE_ITERATIONS sweeps instead, for cloths far larger than the viewer's
+void stepCloth(std::vector<Particle> &particles, std::vector<Constraint> &constraints, ClothMultigrid &multigrid, Vec2 *frame = nullptr);
+
+// largest (length - rest length) / rest length over the active constraints, 0 if none is stretched
+float maxStretch(const std::vector<Constraint> &constraints);
+
+// toggles the pin of the first particle within 10 pixels of the mouse
+void togglePin(float mouseX, float mouseY, std::vector<Particle> &particles, int threadCount = 1);
+
+// deactivates every constraint crossed by the drag path
+void processTear(const std::vector<Vec2> &dragPath, std::vector<Constraint> &constraints, int threadCount = 1);
+
+// particles are written field by field (positions, verlet history, pin flag, zeroed padding), constraints as particle indices since
+// they point into the particle array, and their active flags separately so tears survive a restore
+void saveCloth(SnapshotWriter &writer, const std::vector<Particle> &particles, const std::vector<Constraint> &constraints);
+bool loadCloth(SnapshotReader &reader, std::vector<Particle> &particles, std::vector<Constraint> &constraints);
+
+// bits of the per particle flags published with the cloth's frames, what a viewer needs besides the positions
+const uint8_t CLOTH_FLAG_PINNED = 1;
+const uint8_t CLOTH_FLAG_RIGHT = 2; // the constraint to the next particle in the row is intact
+const uint8_t CLOTH_FLAG_DOWN = 4;  // the constraint to the particle below is intact
+
+// positions go into the ring every step, the flags only after pins or tears changed (see frame_ring.hpp).
+// publishCloth copies the positions out of the particles, a run that passes beginFrame() to stepCloth only commits
+void publishCloth(FrameRingWriter &ring, long long step, const std::vector<Particle> &particles, int threadCount = 1);
+void publishClothFlags(FrameRingWriter &ring, const std::vector<Particle> &particles, const std::vector<Constraint> &constraints, int cols);
+
+bool lineIntersectsLine(const Vec2 &a1, const Vec2 &a2,
+                        const Vec2 &b1, const Vec2 &b2);
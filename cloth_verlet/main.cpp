@@ -1,139 +1,19 @@
-#include <cmath>
 #include <SFML/Graphics.hpp>
+#include <cmath>
+#include <string>
 #include <vector>
-#include <algorithm>
-
-// assuming 100 pixels represent 1 meter, hence gravity is 980
+#include "../renderer/renderer.hpp"
+#include "cloth.hpp"
 
-class Particle
-{
-public:
-    sf::Vector2f position;
-    sf::Vector2f previousPosition;
-    sf::Vector2f acceleration;
-    bool isPinned;
+// viewer and input handling, the physics is in cloth.hpp
 
-    // verlet integration is used, hence the next position is a function of the previous position, current position and the acceleration
-    // "pin" a particle to make its position fixed
-
-    Particle(float x, float y, bool pinned = false)
-        : position(x, y), previousPosition(x, y), acceleration(0, 0), isPinned(pinned) {}
-
-    // since all "particles" have the same mass, you assume some arbitrary unit mass (as its the interaction between them that is of interest)
-
-    void applyForce(const sf::Vector2f &force)
-    {
-        if (!isPinned)
-        {
-            acceleration += force;
-        }
-    }
+// built by the top level CMakeLists.txt when SFML is found
 
-    void update(float timeStep)
-    {
-        if (!isPinned)
-        {
-            sf::Vector2f velocity = position - previousPosition;
-            previousPosition = position;
-            position += velocity + acceleration * timeStep * timeStep;
-            acceleration = sf::Vector2f(0, 0); // Reset acceleration after update
-        }
-        else
-        {
-            previousPosition = position;
-        }
-    }
-
-    void constrainToBounds(float width, float height)
-    {
-        if (position.x < 0.0f)
-            position.x = 0.0f;
-        if (position.x > width)
-            position.x = width;
-        if (position.y < 0.0f)
-            position.y = 0.0f;
-        if (position.y > height - 1.0f)
-            position.y = height - 1.0f;
-    }
-
-    // damping simulates energy loss
-    void applyDamping(float damping)
-    {
-        if (!isPinned)
-        {
-            sf::Vector2f velocity = position - previousPosition;
-            velocity *= damping;
-            previousPosition = position - velocity;
-        }
-    }
-
-    void handleGroundCollision(float groundY)
-    {
-        if (position.y > groundY)
-        {
-            position.y = groundY;
-            if (!isPinned)
-            {
-                sf::Vector2f velocity = position - previousPosition;
-                velocity.y *= -0.5f; // Bounce effect with damping
-                previousPosition.y = position.y - velocity.y;
-            }
-        }
-    }
-};
-
-// shear sprinsg (i,j) and (i+1, j+1)
-// flexion springs (i,j) - (i+2, j) and (i,j+2)
-
-class Constraint
-{
-    // implement the structural forces using constraints
-public:
-    Particle *particle1;
-    Particle *particle2;
-    float restLength;
-    // make inactive if the constraint is broken
-    bool isActive;
-    float stiffness;
-
-    // calculate the rest length between the two particles
-    Constraint(Particle *p1, Particle *p2, float stiffness = 1.0f)
-        : particle1(p1), particle2(p2), isActive(true), stiffness(stiffness)
-    {
-        sf::Vector2f delta = particle2->position - particle1->position;
-        restLength = std::hypot(delta.x, delta.y);
-    }
-
-    // method is based on verlet integration and constraint relaxation
-
-    // constraint projection is the key idea, instead of applying the forces, we directly use the positions of the particles to satisfy the constraints
-    // this makes the method more stable
-
-    // taken from the paper "Advanced Character Physics" by Thomas Jakobsen (specifically the function void ParticleSystem::SatisfyConstraints())
-
-    // note: can optimize to approximate the square root which hasn't been implemented
-    void satisfy()
-    {
-        if (!isActive)
-            return;
-
-        sf::Vector2f delta = particle2->position - particle1->position;
-        float currentLength = std::hypot(delta.x, delta.y);
-
-        // normalize the difference with the current length
-        float diff = (currentLength - restLength) / currentLength;
-
-        // scale the distance between them based on the difference, and multiply by 0.5 so that the correction is equally shared between the two particles
-        sf::Vector2f correction = delta * 0.5f * diff * stiffness;
-
-        if (!particle1->isPinned)
-            particle1->position += correction;
-        if (!particle2->isPinned)
-            particle2->position -= correction;
-    }
-
-    void deactivate() { isActive = false; }
-};
+// P toggles pin mode, W toggles a gusty wind from the left, S saves the cloth (tears and pins included) to cloth.snap, L restores it.
+// the file is a headless checkpoint, `headless resume cloth.snap --steps N` fast-forwards it without a window
+//
+// ./cloth_verlet                  the interactive cloth
+// ./cloth_verlet --attach cloth   only draws the frames `headless cloth --publish cloth` streams through shared memory
 
 // class for input handling
 class InputHandler
@@ -141,8 +21,8 @@ class InputHandler
 public:
     static bool isDragging;
     static bool isPinMode;
-    static sf::Vector2f dragStart;
-    static std::vector<sf::Vector2f> dragPath;
+    static Vec2 dragStart;
+    static std::vector<Vec2> dragPath;
 
     static void handleEvents(const sf::Event &event, std::vector<Constraint> &constraints, std::vector<Particle> &particles)
     {
@@ -161,15 +41,15 @@ public:
         }
     }
 
-    static void drawOverlay(sf::RenderWindow &window)
+    static void drawOverlay(BatchRenderer &renderer, const sf::RenderWindow &window)
     {
         if (isPinMode)
         {
-            drawPinCursor(window);
+            drawPinCursor(renderer, window);
         }
         else if (isDragging && dragPath.size() > 1)
         {
-            drawTearLine(window);
+            drawTearLine(renderer);
         }
     }
 
@@ -180,20 +60,20 @@ private:
         {
             // set isDragging to true, store the start position of the drag
             isDragging = true;
-            dragStart = sf::Vector2f(event.mouseButton.x, event.mouseButton.y);
+            dragStart = Vec2(event.mouseButton.x, event.mouseButton.y);
             dragPath.clear();
             dragPath.push_back(dragStart);
         }
         // if the mouse is moving and isDragging is true, continue to add the current position to the dragPath
         else if (event.type == sf::Event::MouseMoved && isDragging)
         {
-            dragPath.push_back(sf::Vector2f(event.mouseMove.x, event.mouseMove.y));
+            dragPath.push_back(Vec2(event.mouseMove.x, event.mouseMove.y));
         }
         // is mouse is released, and isDragging is true, process the tear
         else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left && isDragging)
         {
             isDragging = false;
-            processTear(constraints);
+            processTear(dragPath, constraints);
             dragPath.clear();
         }
     }
@@ -208,174 +88,125 @@ private:
         }
     }
 
-    // currently brute force
-    // similar optimization like in processTear need to be implemented
-    static void togglePin(float mouseX, float mouseY, std::vector<Particle> &particles)
+    static void drawTearLine(BatchRenderer &renderer)
     {
-        const float pinRadius = 10.0f; // 10 pixels
-        const float pinRadiusSq = pinRadius * pinRadius;
-
-        for (auto &particle : particles)
-        {
-            float dx = particle.position.x - mouseX;
-            float dy = particle.position.y - mouseY;
-            float distSq = dx * dx + dy * dy;
-            if (distSq < pinRadiusSq)
-            {
-                particle.isPinned = !particle.isPinned;
-                break;
-            }
-        }
+        for (size_t i = 1; i < dragPath.size(); ++i)
+            renderer.line(toSf(dragPath[i - 1]), toSf(dragPath[i]), sf::Color::Red);
     }
 
-    // currently implemented by brute force
-    // note: look into
-    // 1) spatial partitioning (quadtree, octree, grid based methods)
-    // 2) sweep and prune
-    // 3) bounding box pre-checks (aabb)
-    // 4) early exit checks
-    // 5) parallelizaiton
-    // 6) simplyfing the drag path maybe using Ramer-Douglas-Peucker algorithm
-    static void processTear(std::vector<Constraint> &constraints)
+    static void drawPinCursor(BatchRenderer &renderer, const sf::RenderWindow &window)
     {
-        for (auto &constraint : constraints)
-        {
-            if (!constraint.isActive)
-                continue;
-            for (size_t i = 0; i < dragPath.size() - 1; ++i)
-            {
-                if (lineIntersectsLine(
-                        dragPath[i], dragPath[i + 1],
-                        constraint.particle1->position, constraint.particle2->position))
-                {
-                    constraint.deactivate();
-                    break; // Move to next constraint after deactivation
-                }
-            }
-        }
+        sf::Vector2i mousePos = sf::Mouse::getPosition(window);
+        renderer.circle(sf::Vector2f(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y)), 5.0f, sf::Color::Blue);
     }
+};
 
-    // using Parametric Line Intersection
-    // determines if two lines intersection in a 2D space
-    static bool lineIntersectsLine(const sf::Vector2f &a1, const sf::Vector2f &a2,
-                                   const sf::Vector2f &b1, const sf::Vector2f &b2)
-    {
+// Initialize static members
+bool InputHandler::isDragging = false;
+bool InputHandler::isPinMode = false;
+Vec2 InputHandler::dragStart = Vec2(0, 0);
+std::vector<Vec2> InputHandler::dragPath;
 
-        // a1 a2 are the end points of the first line segment, b1 and b2 of the second line segment
+// the physics runs in another process and this one maps its frame ring read-only, so viewers can come and go, or
+// stall, without the simulation noticing. when the writer goes away the last frame stays up until the next one starts
+int runAttached(const std::string &name)
+{
+    sf::RenderWindow window(sf::VideoMode(WIDTH, HEIGHT), "Cloth Simulation - " + frameRingPath(name));
+    window.setFramerateLimit(60);
 
-        // calculate the determinant
-        float d = (a2.x - a1.x) * (b2.y - b1.y) - (a2.y - a1.y) * (b2.x - b1.x);
-        if (d == 0.0f)
-            return false;
+    BatchRenderer renderer;
+    renderer.loadFont("Arial.ttf");
 
-        float ua = ((b2.x - b1.x) * (a1.y - b1.y) - (b2.y - b1.y) * (a1.x - b1.x)) / d;
-        float ub = ((a2.x - a1.x) * (a1.y - b1.y) - (a2.y - a1.y) * (a1.x - b1.x)) / d;
+    FrameRingReader ring;
+    Frame frame;
+    std::vector<uint8_t> flags;
+    uint64_t flagsVersion = 0;
+    sf::Clock retryClock;
+    bool firstTry = true;
 
-        return (ua >= 0.0f && ua <= 1.0f && ub >= 0.0f && ub <= 1.0f);
-    }
+    // a cloth larger than the window is scaled down to fit
+    Vec2 offset(0, 0);
+    float scale = 1.0f;
 
-    static void drawTearLine(sf::RenderWindow &window)
+    while (window.isOpen())
     {
-        sf::VertexArray lines(sf::LineStrip, dragPath.size());
-        for (size_t i = 0; i < dragPath.size(); ++i)
+        sf::Event event;
+        while (window.pollEvent(event))
         {
-            lines[i].position = dragPath[i];
-            lines[i].color = sf::Color::Red;
+            if (event.type == sf::Event::Closed)
+                window.close();
         }
-        window.draw(lines);
-    }
-
-    static void drawPinCursor(sf::RenderWindow &window)
-    {
-        sf::CircleShape cursor(5);
-        cursor.setFillColor(sf::Color::Blue);
-        sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-        cursor.setPosition(static_cast<float>(mousePos.x) - 5.0f, static_cast<float>(mousePos.y) - 5.0f);
-        window.draw(cursor);
-    }
-};
 
-const int WIDTH = 1080;
-const int HEIGHT = 640;
-const float GRAVITY = 980.0f;   // Adjusted gravity
-const float TIME_STEP = 0.016f; // 60 FPS, the physics updates 60 times per second
-const float DAMPING = 0.99f;    // reducing damping will make it more bouncy and less resistant to movement
-const int ROWS = 30;
-const int COLS = 30;
-const float REST_DISTANCE = 10.0f;
-const int CONSTRAINT_ITERATIONS = 15;
-
-void resetSimulation(std::vector<Particle> &particles, std::vector<Constraint> &constraints)
-{
-    particles.clear();
-    constraints.clear();
+        if (ring.closed() && (firstTry || retryClock.getElapsedTime().asSeconds() > 0.5f))
+        {
+            firstTry = false;
+            retryClock.restart();
+            if (ring.open(name))
+            {
+                frame.index = 0;
+                flags.clear();
+                flagsVersion = 0;
+            }
+        }
 
-    // Create particles
-    for (int row = 0; row < ROWS; ++row)
-    {
-        for (int col = 0; col < COLS; ++col)
+        ring.flags(flags, flagsVersion);
+        if (ring.latest(frame) && !frame.positions.empty())
         {
-            float x = col * REST_DISTANCE + WIDTH / 3.0f;
-            float y = row * REST_DISTANCE + 50.0f;                         // Start higher on the screen
-            bool pinned = (row == 0 && (col % 5 == 0 or col == COLS - 1)); // Pin every 5th particle on the top row
-            particles.emplace_back(x, y, pinned);
+            Vec2 low(0, 0), high(WIDTH, HEIGHT);
+            for (const Vec2 &p : frame.positions)
+            {
+                low = Vec2(std::min(low.x, p.x), std::min(low.y, p.y));
+                high = Vec2(std::max(high.x, p.x), std::max(high.y, p.y));
+            }
+            scale = std::min(1.0f, std::min(WIDTH / (high.x - low.x), HEIGHT / (high.y - low.y)));
+            offset = scale < 1.0f ? low : Vec2(0, 0);
         }
-    }
 
-    // Create structural constraints (vertical and horizontal)
-    for (int row = 0; row < ROWS; ++row)
-    {
-        for (int col = 0; col < COLS; ++col)
+        renderer.begin();
+
+        const std::vector<Vec2> &positions = frame.positions;
+        auto screen = [&](size_t i)
+        { return toSf((positions[i] - offset) * scale); };
+        const size_t count = positions.size();
+        const size_t cols = static_cast<size_t>(std::max(ring.cols(), 1));
+        if (flags.size() == count)
         {
-            int index = row * COLS + col;
-            if (col < COLS - 1)
+            for (size_t i = 0; i < count; ++i)
             {
-                constraints.emplace_back(&particles[index], &particles[index + 1]);
+                if ((flags[i] & CLOTH_FLAG_RIGHT) && i + 1 < count)
+                    renderer.line(screen(i), screen(i + 1), sf::Color::White);
+                if ((flags[i] & CLOTH_FLAG_DOWN) && i + cols < count)
+                    renderer.line(screen(i), screen(i + cols), sf::Color::White);
             }
-            if (row < ROWS - 1)
+        }
+        // with tens of thousands of particles the circles would only cover the lines
+        if (count <= 10000)
+        {
+            for (size_t i = 0; i < count; ++i)
             {
-                constraints.emplace_back(&particles[index], &particles[index + COLS]);
+                bool pinned = i < flags.size() && (flags[i] & CLOTH_FLAG_PINNED);
+                renderer.circle(screen(i), 3 * std::max(scale, 0.3f), pinned ? sf::Color::Blue : sf::Color(200, 200, 200));
             }
         }
-    }
 
-    // // Create shear constraints (lower stiffness)
-    // for (int row = 0; row < ROWS - 1; ++row)
-    // {
-    //     for (int col = 0; col < COLS - 1; ++col)
-    //     {
-    //         int index = row * COLS + col;
-    //         constraints.emplace_back(&particles[index], &particles[index + COLS + 1], shear_stiffness); // More flexible
-    //         constraints.emplace_back(&particles[index + 1], &particles[index + COLS], shear_stiffness); // More flexible
-    //     }
-    // }
-
-    // // Create bend constraints (medium stiffness)
-    // for (int row = 0; row < ROWS; ++row)
-    // {
-    //     for (int col = 0; col < COLS; ++col)
-    //     {
-    //         int index = row * COLS + col;
-    //         if (col < COLS - 2) // Horizontal bend constraint
-    //         {
-    //             constraints.emplace_back(&particles[index], &particles[index + 2], flexion_stiffness); // Moderate flexibility
-    //         }
-    //         if (row < ROWS - 2) // Vertical bend constraint
-    //         {
-    //             constraints.emplace_back(&particles[index], &particles[index + 2 * COLS], flexion_stiffness); // Moderate flexibility
-    //         }
-    //     }
-    // }
-}
+        std::string status = ring.closed() ? "Waiting for " + frameRingPath(name)
+                                           : "Attached to " + frameRingPath(name) + ", step " + std::to_string(frame.step);
+        renderer.text(0, status, sf::Vector2f(10, 10), 18, sf::Color::Yellow);
 
-// Initialize static members
-bool InputHandler::isDragging = false;
-bool InputHandler::isPinMode = false;
-sf::Vector2f InputHandler::dragStart = sf::Vector2f(0, 0);
-std::vector<sf::Vector2f> InputHandler::dragPath;
+        window.clear(sf::Color(50, 50, 50));
+        renderer.flush(window);
+        window.display();
+    }
+    return 0;
+}
 
-int main()
+int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "--attach")
+    {
+        return runAttached(argc > 2 ? argv[2] : "cloth");
+    }
+
     sf::RenderWindow window(sf::VideoMode(WIDTH, HEIGHT), "Cloth Simulation with Verlet Integration");
 
     std::vector<Particle> particles;
@@ -383,9 +214,13 @@ int main()
 
     resetSimulation(particles, constraints);
 
-    sf::RectangleShape resetButton(sf::Vector2f(100.0f, 40.0f));
-    resetButton.setPosition(WIDTH - 120.0f, HEIGHT - 60.0f);
-    resetButton.setFillColor(sf::Color::Red);
+    sf::FloatRect resetButton(WIDTH - 120.0f, HEIGHT - 60.0f, 100.0f, 40.0f);
+
+    BatchRenderer renderer;
+    if (!renderer.loadFont("Arial.ttf"))
+    {
+        // Handle error
+    }
 
     // measures the amount of time between frames
     sf::Clock clock;
@@ -394,6 +229,11 @@ int main()
     // helps in decoupling the physics from the rendering
     // tracks how much time remains that hasn't been simulated
     float accumulator = 0.0f;
+    long long stepCount = 0;
+
+    ClothWind wind(ROWS, COLS);
+    bool windOn = false;
+    const int threads = hardwareThreads();
 
     while (window.isOpen())
     {
@@ -407,11 +247,37 @@ int main()
                 float mouseX = static_cast<float>(event.mouseButton.x);
                 float mouseY = static_cast<float>(event.mouseButton.y);
 
-                if (resetButton.getGlobalBounds().contains(mouseX, mouseY))
+                if (resetButton.contains(mouseX, mouseY))
                 {
                     resetSimulation(particles, constraints); // Reset the simulation
                 }
             }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::W)
+            {
+                windOn = !windOn;
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::S)
+            {
+                SnapshotWriter writer;
+                writer.run("cloth", stepCount, 0);
+                saveCloth(writer, particles, constraints);
+                writer.writeFile("cloth.snap");
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::L)
+            {
+                SnapshotReader reader;
+                RunInfo info;
+                std::vector<Particle> loadedParticles;
+                std::vector<Constraint> loadedConstraints;
+                // only replace the running cloth once the whole file has loaded
+                if (reader.open("cloth.snap") && reader.run(info) && std::string(info.name) == "cloth" &&
+                    loadCloth(reader, loadedParticles, loadedConstraints))
+                {
+                    particles.swap(loadedParticles);
+                    constraints.swap(loadedConstraints);
+                    stepCount = info.step;
+                }
+            }
             InputHandler::handleEvents(event, constraints, particles);
         }
 
@@ -420,101 +286,58 @@ int main()
         accumulator += deltaTime;
         while (accumulator >= TIME_STEP)
         {
-            // Update particles
-            // we are polling every single particle
-            // brute force
-            // note: look into
-            // 1) spatial partitioning (quadtree, octree, grid based methods)
-            // 2) broad phase and narrow phase collision detection
-            // 3) variable time stepping
-            // 4) parallelizaiton
-            // 5) reducing constraint equations dynamically
-            // 6) early exit constraint satisfaction
-            // 7) perhaps a larger rest distance
-            for (auto &particle : particles)
+            if (windOn)
             {
-                particle.applyForce(sf::Vector2f(0, GRAVITY));
-                particle.update(TIME_STEP);
-                particle.applyDamping(DAMPING);
-                particle.handleGroundCollision(HEIGHT - 1.0f); // Ground at bottom of the window
-            }
-
-            // increasing makes more accurate, stiffer, and more stable but also increases computational cost
-            for (int i = 0; i < CONSTRAINT_ITERATIONS; ++i)
-            {
-                for (auto &constraint : constraints)
-                {
-                    constraint.satisfy();
-                }
+                // gusts: the speed swells and fades and the direction wanders a little
+                float t = stepCount * TIME_STEP;
+                float speed = 350.0f + 250.0f * std::sin(0.9f * t) * std::sin(0.23f * t);
+                float angle = 0.3f * std::sin(0.5f * t);
+                wind.velocity = Vec2(std::cos(angle), std::sin(angle)) * speed;
+                wind.apply(particles, constraints, threads);
             }
+            stepCloth(particles, constraints);
+            stepCount++;
 
             accumulator -= TIME_STEP;
         }
 
-        window.clear(sf::Color(50, 50, 50)); // Dark gray background
+        renderer.begin();
 
         // Draw constraints (cloth)
         for (const auto &constraint : constraints)
         {
             if (!constraint.isActive)
                 continue;
-            sf::Vertex line[] = {
-                sf::Vertex(constraint.particle1->position, sf::Color::White),
-                sf::Vertex(constraint.particle2->position, sf::Color::White),
-            };
-            window.draw(line, 2, sf::Lines);
+            renderer.line(toSf(constraint.particle1->position), toSf(constraint.particle2->position), sf::Color::White);
         }
 
         // Draw particles
         for (const auto &particle : particles)
         {
-            sf::CircleShape circle(3);
-            circle.setPosition(particle.position - sf::Vector2f(3, 3));
-            if (particle.isPinned)
-            {
-                circle.setFillColor(sf::Color::Blue);
-            }
-            else
-            {
-                circle.setFillColor(sf::Color(200, 200, 200)); // Light gray for unpinned particles
-            }
-            window.draw(circle);
+            // Light gray for unpinned particles
+            renderer.circle(toSf(particle.position), 3, particle.isPinned ? sf::Color::Blue : sf::Color(200, 200, 200));
         }
 
         // Draw tear line or pin cursor
-        InputHandler::drawOverlay(window);
+        InputHandler::drawOverlay(renderer, window);
+
+        renderer.quad(sf::Vector2f(resetButton.left, resetButton.top), sf::Vector2f(resetButton.width, resetButton.height), sf::Color::Red);
+        renderer.text(0, "Reset", sf::Vector2f(WIDTH - 100.0f, HEIGHT - 50.0f), 18, sf::Color::White);
+
+        renderer.text(2, windOn ? "Wind: on (Press 'W' to switch)" : "Wind: off (Press 'W' to switch)", sf::Vector2f(10, 34), 18, sf::Color::Yellow);
 
         // Display mode text
-        sf::Font font;
-        if (!font.loadFromFile("arial.ttf"))
-        {
-            // Handle error
-        }
-        window.draw(resetButton);
-
-        sf::Text resetText;
-        resetText.setFont(font);
-        resetText.setString("Reset");
-        resetText.setCharacterSize(18);
-        resetText.setFillColor(sf::Color::White);
-        resetText.setPosition(WIDTH - 100.0f, HEIGHT - 50.0f);
-        window.draw(resetText);
-
-        sf::Text modeText;
-        modeText.setFont(font);
-        modeText.setCharacterSize(18);
-        modeText.setFillColor(sf::Color::Yellow);
-        modeText.setPosition(10, 10);
         if (InputHandler::isPinMode)
         {
-            modeText.setString("Mode: Pinning (Press 'P' to switch)");
+            renderer.text(1, "Mode: Pinning (Press 'P' to switch)", sf::Vector2f(10, 10), 18, sf::Color::Yellow);
         }
         else
         {
-            modeText.setString("Mode: Normal (Press 'P' to switch)");
+            renderer.text(1, "Mode: Normal (Press 'P' to switch)", sf::Vector2f(10, 10), 18, sf::Color::Yellow);
         }
-        window.draw(modeText);
 
+        window.clear(sf::Color(50, 50, 50)); // Dark gray background
+        renderer.flush(window);
         window.display();
     }
 
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "snapshot.hpp"
+#include "vec2.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// live particle positions of a running simulation in POSIX shared memory, for viewers in other processes
+//
+// the simulation creates the ring and publishes into it every step, any number of viewers map it read-only and come
+// and go while it runs. nothing is serialized or sent through a socket, and the writer never waits for its readers or
+// even knows they are there: every slot is a seqlock. the writer makes the slot's sequence odd, fills the slot and
+// makes it even again; a reader copies the newest slot and keeps the copy only if the sequence was the same even
+// number before and after. with slotCount slots a reader has slotCount - 1 publishes of time to copy a frame before
+// the writer comes round to its slot again. the slot can be filled by the simulation's own step (beginFrame and
+// commitFrame), then a publish costs the same at 10^6 particles as at 10
+//
+//   header   magic "SIMRING", version, slot count, capacity, simulation name, grid columns, particle radius,
+//            frames published so far, closed flag
+//   slot     sequence, step, particle count, then capacity positions (Vec2)
+//   flags    sequence, count, then one byte per particle for what changes now and then (the cloth's pins and tears),
+//            only republished when it changes
+//
+// every block starts on a 64 byte line, so the writer's sequence stores never share a cache line with another slot
+
+const char FRAME_RING_MAGIC[8] = {'S', 'I', 'M', 'R', 'I', 'N', 'G', '\0'};
+const uint32_t FRAME_RING_VERSION = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring's counters are shared between processes");
+
+struct FrameRingHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t capacity; // positions per slot
+    char name[16];     // the simulation publishing, as in RunInfo
+    int32_t cols;      // particles per row when they form a grid (the cloth), 0 otherwise
+    float radius;      // drawing radius of a particle
+    alignas(64) std::atomic<uint64_t> published; // frames so far, the newest is in slot (published - 1) % slotCount
+    std::atomic<uint32_t> closed;                // set when the writer goes away
+};
+
+// also the header of the flags block, which leaves step unused
+struct alignas(64) FrameSlot
+{
+    std::atomic<uint64_t> sequence;
+    int64_t step;
+    uint64_t count;
+};
+static_assert(sizeof(FrameSlot) == 64, "slot data starts one cache line after the slot");
+
+inline size_t frameRingLine(size_t bytes) { return (bytes + 63) & ~size_t(63); }
+
+// "cloth" and "/cloth" name the same ring (/dev/shm/cloth on linux)
+inline std::string frameRingPath(const std::string &name) { return name.empty() || name[0] != '/' ? "/" + name : name; }
+
+struct FrameRingLayout
+{
+    size_t slotBytes, flagsOffset, totalBytes;
+
+    FrameRingLayout(uint64_t capacity, uint32_t slotCount)
+    {
+        slotBytes = 64 + frameRingLine(capacity * sizeof(Vec2));
+        flagsOffset = frameRingLine(sizeof(FrameRingHeader)) + slotCount * slotBytes;
+        totalBytes = flagsOffset + 64 + frameRingLine(capacity);
+    }
+};
+
+class FrameRingWriter
+{
+public:
+    FrameRingWriter() = default;
+    FrameRingWriter(const FrameRingWriter &) = delete;
+    FrameRingWriter &operator=(const FrameRingWriter &) = delete;
+
+    ~FrameRingWriter() { close(); }
+
+    // a ring left behind under the same name (a writer that crashed) is marked closed and replaced,
+    // viewers still mapping it let go of it and attach to the new one
+    bool create(const std::string &name, const std::string &simulation, size_t capacity, int cols = 0, float radius = 1.0f, uint32_t slotCount = 4)
+    {
+        close();
+        path = frameRingPath(name);
+        closeStale(path);
+        shm_unlink(path.c_str());
+
+        FrameRingLayout layout(capacity, std::max(2u, slotCount));
+        int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+            return false;
+        // populated up front, otherwise the first publish into every slot pays a page fault per 4 KB
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE;
+#endif
+        void *memory = MAP_FAILED;
+        if (ftruncate(fd, static_cast<off_t>(layout.totalBytes)) == 0)
+            memory = mmap(nullptr, layout.totalBytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(path.c_str());
+            return false;
+        }
+        mapped = static_cast<unsigned char *>(memory);
+        size = layout.totalBytes;
+        slotBytes = layout.slotBytes;
+        flagsOffset = layout.flagsOffset;
+
+        // the file is zero filled, the atomics are constructed in place before the magic tells readers it is valid
+        FrameRingHeader *ring = new (mapped) FrameRingHeader;
+        ring->version = FRAME_RING_VERSION;
+        ring->slotCount = std::max(2u, slotCount);
+        ring->capacity = capacity;
+        copyName(ring->name, sizeof(ring->name) - 1, simulation.c_str());
+        ring->cols = cols;
+        ring->radius = radius;
+        ring->published.store(0, std::memory_order_relaxed);
+        ring->closed.store(0, std::memory_order_relaxed);
+        for (uint32_t s = 0; s < ring->slotCount; ++s)
+            new (slot(s)) FrameSlot{};
+        new (mapped + flagsOffset) FrameSlot{};
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(ring->magic, FRAME_RING_MAGIC, sizeof(FRAME_RING_MAGIC));
+        return true;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    size_t capacity() const { return mapped ? header()->capacity : 0; }
+
+    // zero copy publishing: beginFrame() hands out the count positions of the slot after the newest one, the
+    // simulation writes them from the pass of its step that produces them anyway, and commitFrame() makes the frame
+    // the newest. committing is a few stores whatever the frame size; from begin to commit the slot's sequence is odd
+    // and readers skip it. nullptr when the ring is not open or count is over the capacity.
+    // calling beginFrame() again before a commit returns the same slot
+    Vec2 *beginFrame(size_t count)
+    {
+        if (!mapped || count > header()->capacity)
+            return nullptr;
+        if (!pending)
+        {
+            FrameRingHeader *ring = header();
+            pending = slot(static_cast<uint32_t>(ring->published.load(std::memory_order_relaxed) % ring->slotCount));
+            uint64_t sequence = pending->sequence.load(std::memory_order_relaxed);
+            pending->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        pending->count = count;
+        return reinterpret_cast<Vec2 *>(reinterpret_cast<unsigned char *>(pending) + 64);
+    }
+
+    bool framePending() const { return pending != nullptr; }
+
+    void commitFrame(long long step)
+    {
+        if (!pending)
+            return;
+        FrameRingHeader *ring = header();
+        pending->step = step;
+        pending->sequence.store(pending->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        pending = nullptr;
+        ring->published.store(ring->published.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // fill(Vec2 *positions) writes the count positions straight into the slot, for simulations whose step has no pass
+    // to do it in. a frame larger than the capacity is dropped
+    template <typename Fill>
+    void publish(long long step, size_t count, Fill &&fill)
+    {
+        Vec2 *positions = beginFrame(count);
+        if (!positions)
+            return;
+        fill(positions);
+        commitFrame(step);
+    }
+
+    void publish(long long step, const Vec2 *positions, size_t count)
+    {
+        publish(step, count, [&](Vec2 *out)
+                { std::memcpy(out, positions, count * sizeof(Vec2)); });
+    }
+
+    void publishFlags(const uint8_t *flags, size_t count)
+    {
+        if (!mapped)
+            return;
+        FrameSlot *target = reinterpret_cast<FrameSlot *>(mapped + flagsOffset);
+        uint64_t sequence = target->sequence.load(std::memory_order_relaxed);
+        target->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        target->count = std::min<uint64_t>(count, header()->capacity);
+        std::memcpy(mapped + flagsOffset + 64, flags, target->count);
+        target->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // viewers keep their mapping until they notice, the name is free for the next writer at once
+    void close()
+    {
+        if (!mapped)
+            return;
+        header()->closed.store(1, std::memory_order_release);
+        munmap(mapped, size);
+        shm_unlink(path.c_str());
+        mapped = nullptr;
+        pending = nullptr;
+    }
+
+private:
+    unsigned char *mapped = nullptr;
+    size_t size = 0, slotBytes = 0, flagsOffset = 0;
+    std::string path;
+    FrameSlot *pending = nullptr; // between beginFrame and commitFrame
+
+    FrameRingHeader *header() const { return reinterpret_cast<FrameRingHeader *>(mapped); }
+    FrameSlot *slot(uint32_t s) const { return reinterpret_cast<FrameSlot *>(mapped + frameRingLine(sizeof(FrameRingHeader)) + s * slotBytes); }
+
+    static void closeStale(const std::string &path)
+    {
+        int fd = shm_open(path.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return;
+        void *memory = mmap(nullptr, sizeof(FrameRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+            return;
+        FrameRingHeader *stale = static_cast<FrameRingHeader *>(memory);
+        if (std::memcmp(stale->magic, FRAME_RING_MAGIC, sizeof(FRAME_RING_MAGIC)) == 0)
+            stale->closed.store(1, std::memory_order_release);
+        munmap(memory, sizeof(FrameRingHeader));
+    }
+};
+
+// one frame as a viewer sees it; index is the writer's publish count, so a viewer can tell a new frame from the last one
+struct Frame
+{
+    uint64_t index = 0;
+    long long step = 0;
+    std::vector<Vec2> positions;
+};
+
+// maps a ring read-only, nothing a reader does is visible to the writer
+class FrameRingReader
+{
+public:
+    FrameRingReader() = default;
+    FrameRingReader(const FrameRingReader &) = delete;
+    FrameRingReader &operator=(const FrameRingReader &) = delete;
+
+    ~FrameRingReader() { close(); }
+
+    bool open(const std::string &name)
+    {
+        close();
+        int fd = shm_open(frameRingPath(name).c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(FrameRingHeader))
+        {
+            size = static_cast<size_t>(info.st_size);
+            void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            mapped = memory == MAP_FAILED ? nullptr : static_cast<const unsigned char *>(memory);
+        }
+        ::close(fd);
+        if (!mapped)
+            return false;
+
+        const FrameRingHeader *ring = header();
+        if (std::memcmp(ring->magic, FRAME_RING_MAGIC, sizeof(FRAME_RING_MAGIC)) != 0 || ring->version != FRAME_RING_VERSION ||
+            ring->slotCount < 2 || FrameRingLayout(ring->capacity, ring->slotCount).totalBytes != size)
+        {
+            close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        FrameRingLayout layout(ring->capacity, ring->slotCount);
+        slotBytes = layout.slotBytes;
+        flagsOffset = layout.flagsOffset;
+        return true;
+    }
+
+    void close()
+    {
+        if (mapped)
+            munmap(const_cast<unsigned char *>(mapped), size);
+        mapped = nullptr;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    // the writer went away (or was replaced), open() again to follow the next one
+    bool closed() const { return !mapped || header()->closed.load(std::memory_order_acquire) != 0; }
+
+    std::string simulation() const { return mapped ? std::string(header()->name, strnlen(header()->name, sizeof(header()->name))) : std::string(); }
+    int cols() const { return mapped ? header()->cols : 0; }
+    float radius() const { return mapped ? header()->radius : 0.0f; }
+
+    // copies the newest frame into frame if it is newer than the one already there. false when there is nothing
+    // new, or the writer kept overwriting the slot being copied (it is publishing faster than a frame can be copied)
+    bool latest(Frame &frame)
+    {
+        if (!mapped)
+            return false;
+        const FrameRingHeader *ring = header();
+        for (int attempt = 0; attempt < 4; ++attempt)
+        {
+            uint64_t published = ring->published.load(std::memory_order_acquire);
+            if (published == 0 || published == frame.index)
+                return false;
+            const FrameSlot *source = slot(static_cast<uint32_t>((published - 1) % ring->slotCount));
+            uint64_t before = source->sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+            long long step = source->step;
+            size_t count = static_cast<size_t>(std::min<uint64_t>(source->count, ring->capacity));
+            frame.positions.resize(count);
+            std::memcpy(frame.positions.data(), reinterpret_cast<const unsigned char *>(source) + 64, count * sizeof(Vec2));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (source->sequence.load(std::memory_order_relaxed) != before)
+                continue;
+            frame.index = published;
+            frame.step = step;
+            return true;
+        }
+        return false;
+    }
+
+    // copies the flags if they changed since version (0 = never read), same seqlock as the frames
+    bool flags(std::vector<uint8_t> &values, uint64_t &version)
+    {
+        if (!mapped)
+            return false;
+        const FrameSlot *source = reinterpret_cast<const FrameSlot *>(mapped + flagsOffset);
+        for (int attempt = 0; attempt < 4; ++attempt)
+        {
+            uint64_t before = source->sequence.load(std::memory_order_acquire);
+            if (before == version || before == 0)
+                return false;
+            if (before & 1)
+                continue;
+            size_t count = static_cast<size_t>(std::min<uint64_t>(source->count, header()->capacity));
+            values.resize(count);
+            std::memcpy(values.data(), mapped + flagsOffset + 64, count);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (source->sequence.load(std::memory_order_relaxed) != before)
+                continue;
+            version = before;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const unsigned char *mapped = nullptr;
+    size_t size = 0, slotBytes = 0, flagsOffset = 0;
+
+    const FrameRingHeader *header() const { return reinterpret_cast<const FrameRingHeader *>(mapped); }
+    const FrameSlot *slot(uint32_t s) const { return reinterpret_cast<const FrameSlot *>(mapped + frameRingLine(sizeof(FrameRingHeader)) + s * slotBytes); }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// items a thread should get at least in the loops that only spend a few ns per item (gathers, picking, per particle
+// forces), below that starting the thread costs more than it saves
+const int CHEAP_LOOP_GRAIN = 4096;
+
+// threads parallelFor really uses for count items, so that every thread gets at least minGrain of them
+inline int parallelThreadCount(int count, int threadCount, int minGrain = 1)
+{
+    return std::max(1, std::min(threadCount, count / std::max(minGrain, 1)));
+}
+
+// splits [0, count) into contiguous chunks, one per thread, and only uses as many threads as get minGrain items each
+template <typename F>
+void parallelFor(int count, int threadCount, int minGrain, F &&f)
+{
+    threadCount = parallelThreadCount(count, threadCount, minGrain);
+    if (threadCount == 1)
+    {
+        f(0, count);
+        return;
+    }
+    std::vector<std::thread> threads;
+    int chunk = (count + threadCount - 1) / threadCount;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        int begin = t * chunk;
+        int end = std::min(count, begin + chunk);
+        if (begin < end)
+            threads.emplace_back([&f, begin, end]
+                                 { f(begin, end); });
+    }
+    for (auto &thread : threads)
+        thread.join();
+}
+
+template <typename F>
+void parallelFor(int count, int threadCount, F &&f)
+{
+    parallelFor(count, threadCount, 1, std::forward<F>(f));
+}
+
+inline int hardwareThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// binary snapshots of simulation state, used for checkpoints and to restore a run exactly where it was
+//
+// a file is a 16 byte header followed by sections, each section is one array of trivially copyable records:
+//
+//   header   char magic[8] = "SIMSNAP", uint32 version, uint32 reserved
+//   section  char tag[8], uint64 elementSize, uint64 count, then count * elementSize bytes padded to 8
+//
+// records are the in-memory structs written as they are (native byte order, native padding), so saving is one
+// memcpy per array and a reader can hand out pointers straight into the mapped file. elementSize is checked on
+// load so a snapshot from a build with a different struct layout is rejected instead of misread.
+// sections are read back in the order they were written, every simulation writes its own fixed sequence
+
+// fixed size name fields are zero filled and only nul terminated when the name is shorter than the field
+inline void copyName(char *field, size_t size, const char *name)
+{
+    std::memset(field, 0, size);
+    std::memcpy(field, name, std::min(std::strlen(name), size));
+}
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'I', 'M', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// first section of a checkpoint: the simulation that wrote it, its step and its --count, so the headless runner can
+// recreate the simulation before loading the simulation's own sections
+struct RunInfo
+{
+    char name[16];
+    long long step;
+    int count;
+    int unused; // explicit padding
+};
+
+class SnapshotWriter
+{
+public:
+    SnapshotWriter()
+    {
+        append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        uint32_t header[2] = {SNAPSHOT_VERSION, 0};
+        append(header, sizeof(header));
+    }
+
+    template <typename T>
+    void array(const char *tag, const T *data, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot records are copied as raw bytes");
+        char name[8];
+        copyName(name, sizeof(name), tag);
+        uint64_t sizes[2] = {sizeof(T), count};
+        append(name, sizeof(name));
+        append(sizes, sizeof(sizes));
+        append(data, sizeof(T) * count);
+        buffer.resize((buffer.size() + 7) & ~size_t(7), 0);
+    }
+
+    template <typename T>
+    void array(const char *tag, const std::vector<T> &values) { array(tag, values.data(), values.size()); }
+
+    template <typename T>
+    void value(const char *tag, const T &v) { array(tag, &v, 1); }
+
+    void run(const std::string &name, long long step, int count)
+    {
+        RunInfo info = {};
+        copyName(info.name, sizeof(info.name) - 1, name.c_str());
+        info.step = step;
+        info.count = count;
+        value("run", info);
+    }
+
+    const std::vector<unsigned char> &bytes() const { return buffer; }
+
+    // written to a temporary file and renamed, so a crash mid-write never leaves a truncated checkpoint behind
+    bool writeFile(const std::string &path) const
+    {
+        std::string temporary = path + ".tmp";
+        std::FILE *file = std::fopen(temporary.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        ok = std::fclose(file) == 0 && ok;
+        return ok && std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+private:
+    std::vector<unsigned char> buffer;
+
+    void append(const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+};
+
+// maps a snapshot file read-only; array() returns pointers into the mapping, valid while the reader lives
+// every read fails (returns nullptr / false) once one has failed, so a loader can check ok() once at the end
+class SnapshotReader
+{
+public:
+    SnapshotReader() = default;
+    SnapshotReader(const SnapshotReader &) = delete;
+    SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+    ~SnapshotReader()
+    {
+        if (mapped)
+            munmap(mapped, size);
+    }
+
+    bool open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= 16)
+        {
+            size = static_cast<size_t>(info.st_size);
+            void *memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            mapped = memory == MAP_FAILED ? nullptr : memory;
+        }
+        ::close(fd);
+        if (!mapped)
+            return false;
+
+        uint32_t version = 0;
+        std::memcpy(&version, bytes() + 8, sizeof(version));
+        failed = std::memcmp(bytes(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || version != SNAPSHOT_VERSION;
+        offset = 16;
+        return !failed;
+    }
+
+    template <typename T>
+    const T *array(const char *tag, size_t &count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot records are copied as raw bytes");
+        count = 0;
+        if (failed || offset + 24 > size)
+        {
+            failed = true;
+            return nullptr;
+        }
+
+        char name[8];
+        copyName(name, sizeof(name), tag);
+        uint64_t sizes[2];
+        std::memcpy(sizes, bytes() + offset + 8, sizeof(sizes));
+        if (std::memcmp(bytes() + offset, name, sizeof(name)) != 0 || sizes[0] != sizeof(T) ||
+            sizes[1] > (size - offset - 24) / sizeof(T))
+        {
+            failed = true;
+            return nullptr;
+        }
+
+        const T *data = reinterpret_cast<const T *>(bytes() + offset + 24);
+        count = static_cast<size_t>(sizes[1]);
+        offset = (offset + 24 + sizeof(T) * count + 7) & ~size_t(7);
+        return data;
+    }
+
+    // copies a section into a vector, one memcpy
+    template <typename T>
+    bool array(const char *tag, std::vector<T> &values)
+    {
+        size_t count;
+        const T *data = array<T>(tag, count);
+        if (!data)
+            return false;
+        values.assign(data, data + count);
+        return true;
+    }
+
+    template <typename T>
+    bool value(const char *tag, T &v)
+    {
+        size_t count;
+        const T *data = array<T>(tag, count);
+        if (!data || count != 1)
+        {
+            failed = true;
+            return false;
+        }
+        v = *data;
+        return true;
+    }
+
+    bool run(RunInfo &info)
+    {
+        if (!value("run", info))
+            return false;
+        info.name[sizeof(info.name) - 1] = '\0';
+        return true;
+    }
+
+    bool ok() const { return !failed; }
+
+private:
+    void *mapped = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+    bool failed = true;
+
+    const unsigned char *bytes() const { return static_cast<const unsigned char *>(mapped); }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+
+// 2d float vector used by the physics cores instead of sf::Vector2f, so they build without SFML
+// same layout and operators as sf::Vector2f, the viewers convert with toSf() from renderer.hpp
+struct Vec2
+{
+    float x = 0.0f;
+    float y = 0.0f;
+
+    Vec2() = default;
+    Vec2(float x, float y) : x(x), y(y) {}
+
+    Vec2 &operator+=(const Vec2 &o)
+    {
+        x += o.x;
+        y += o.y;
+        return *this;
+    }
+    Vec2 &operator-=(const Vec2 &o)
+    {
+        x -= o.x;
+        y -= o.y;
+        return *this;
+    }
+    Vec2 &operator*=(float s)
+    {
+        x *= s;
+        y *= s;
+        return *this;
+    }
+};
+
+inline Vec2 operator+(Vec2 a, const Vec2 &b) { return a += b; }
+inline Vec2 operator-(Vec2 a, const Vec2 &b) { return a -= b; }
+inline Vec2 operator-(const Vec2 &a) { return Vec2(-a.x, -a.y); }
+inline Vec2 operator*(Vec2 a, float s) { return a *= s; }
+inline Vec2 operator*(float s, Vec2 a) { return a *= s; }
+inline Vec2 operator/(const Vec2 &a, float s) { return Vec2(a.x / s, a.y / s); }
+inline bool operator==(const Vec2 &a, const Vec2 &b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(const Vec2 &a, const Vec2 &b) { return !(a == b); }
+
+// axis aligned rectangle, same fields as sf::FloatRect
+struct Box
+{
+    float left = 0.0f;
+    float top = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+
+    Box() = default;
+    Box(float left, float top, float width, float height) : left(left), top(top), width(width), height(height) {}
+
+    bool contains(float px, float py) const
+    {
+        return px >= left && px < left + width && py >= top && py < top + height;
+    }
+};
@@ -0,0 +1,620 @@
+#include "../ball_in_box/ball.hpp"
+#include "../ball_in_box/barnes_hut.hpp"
+#include "../ball_in_box/event_sim.hpp"
+#include "../cloth_verlet/cloth.hpp"
+#include "../common/parallel.hpp"
+#include "../common/snapshot.hpp"
+#include "../pendulum/pendulum.hpp"
+#include "../snake/snake.hpp"
+#include "raster.hpp"
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// headless runner: steps any of the simulations without a window and without SFML, as fast as the CPU allows.
+// every --frames steps the state is drawn with the software rasterizer and written to --out as a PPM
+//
+// built by the top level CMakeLists.txt, the benchmarks are in bench/
+//
+// ./headless cloth --steps 100000 --frames 1000 --out frames
+// ./headless events --count 5000 --steps 600
+// ./headless pile --steps 600                                            the same balls under gravity, settling into a pile
+// ./headless pendulum --steps 1000000 --checkpoint 100000 --out ckpt     fast-forward, a checkpoint every 100000 steps
+// ./headless resume ckpt/pendulum_00500000.snap --steps 600000           continue from step 500000 to 600000
+// ./headless cloth --count 1024 --steps 100000 --publish cloth            a 1024 x 1024 cloth streamed to `cloth_verlet --attach cloth`
+
+// every simulation is stepped with the fixed dt its viewer uses at 60 fps
+const double FRAME_DT = 1.0 / 60.0;
+
+class HeadlessSimulation
+{
+public:
+    virtual ~HeadlessSimulation() = default;
+    // ring is the --publish ring, open or not. a run whose step has a pass over every position writes them into
+    // ring.beginFrame() there and its publish() only commits, the others copy the frame out in publish()
+    virtual void step(FrameRingWriter &ring) = 0;
+    virtual void draw(Canvas &canvas) const = 0;
+    virtual void save(SnapshotWriter &writer) const = 0;
+    virtual bool load(SnapshotReader &reader) = 0;
+    virtual int width() const { return 800; }
+    virtual int height() const { return 600; }
+
+    // streaming to viewers in other processes (--publish, see common/frame_ring.hpp), only the ball and cloth runs have frames
+    virtual bool createRing(FrameRingWriter &, const std::string &) const { return false; }
+    virtual void publish(FrameRingWriter &, long long) const {}
+};
+
+// the single bouncing ball of the default viewer, or count balls with ball-ball collisions
+class BallRun : public HeadlessSimulation
+{
+public:
+    explicit BallRun(int count) : boxBounds(100, 100, 600, 400)
+    {
+        if (count <= 1)
+        {
+            balls.emplace_back(400, 400, 10, 200, 500, 0, 980.0f, 0.8f);
+            return;
+        }
+        scatterBalls(boxBounds, count, 4.0f, 150.0f, 42, [&](float x, float y, float r, float vx, float vy)
+                     { balls.emplace_back(x, y, r, vx, vy, 0.0f, 980.0f, 0.8f); });
+    }
+
+    void step(FrameRingWriter &) override { stepBalls(balls, static_cast<float>(FRAME_DT), boxBounds); }
+    void save(SnapshotWriter &writer) const override { saveBalls(writer, balls); }
+    bool load(SnapshotReader &reader) override { return loadBalls(reader, balls); }
+
+    bool createRing(FrameRingWriter &ring, const std::string &name) const override
+    {
+        return ring.create(name, "ball", balls.size(), 0, balls.front().radius);
+    }
+
+    void publish(FrameRingWriter &ring, long long step) const override { publishBalls(ring, step, balls); }
+
+    void draw(Canvas &canvas) const override
+    {
+        canvas.clear({0, 0, 0});
+        canvas.rectOutline(boxBounds, 5, {255, 255, 255});
+        for (const auto &ball : balls)
+            canvas.fillCircle(Vec2(ball.x, ball.y), ball.radius, {255, 0, 0});
+    }
+
+private:
+    Box boxBounds;
+    std::vector<Ball> balls;
+};
+
+// balls with the event driven engine: a gas, or with gravity a pile settling on the floor (restitution as BallRun's)
+class EventRun : public HeadlessSimulation
+{
+public:
+    EventRun(int count, bool gravity)
+        : boxBounds(100, 100, 600, 400), sim(boxBounds, 0.0, gravity ? 980.0 : 0.0, gravity ? 0.8 : 1.0)
+    {
+        scatterBalls(boxBounds, count, 4.0f, 150.0f, 42, [&](float x, float y, float r, float vx, float vy)
+                     { sim.addBall(x, y, r, vx, vy); });
+        sim.initialize();
+    }
+
+    void step(FrameRingWriter &) override
+    {
+        steps++;
+        sim.advanceTo(steps * FRAME_DT);
+    }
+
+    void save(SnapshotWriter &writer) const override
+    {
+        writer.value("steps", steps);
+        sim.save(writer);
+    }
+
+    bool load(SnapshotReader &reader) override { return reader.value("steps", steps) && sim.load(reader); }
+
+    bool createRing(FrameRingWriter &ring, const std::string &name) const override
+    {
+        return ring.create(name, "events", sim.balls.size(), 0, static_cast<float>(sim.balls.front().radius));
+    }
+
+    // the stored positions are those of each ball's last event, the frame needs them at the current time
+    void publish(FrameRingWriter &ring, long long step) const override
+    {
+        ring.publish(step, sim.balls.size(), [&](Vec2 *positions)
+                     {
+                         for (size_t i = 0; i < sim.balls.size(); ++i)
+                             positions[i] = sim.positionAt(static_cast<int>(i), sim.time);
+                     });
+    }
+
+    void draw(Canvas &canvas) const override
+    {
+        canvas.clear({0, 0, 0});
+        canvas.rectOutline(boxBounds, 5, {255, 255, 255});
+        for (size_t i = 0; i < sim.balls.size(); ++i)
+            canvas.fillCircle(sim.positionAt(static_cast<int>(i), sim.time), static_cast<float>(sim.balls[i].radius), {255, 0, 0});
+    }
+
+private:
+    Box boxBounds;
+    EventDrivenSimulation sim;
+    long long steps = 0;
+};
+
+// same setup as the viewer's --nbody mode
+class NBodyRun : public HeadlessSimulation
+{
+public:
+    explicit NBodyRun(int count) : boxBounds(100, 100, 600, 400), threads(hardwareThreads())
+    {
+        Vec2 center(boxBounds.left + boxBounds.width / 2, boxBounds.top + boxBounds.height / 2);
+        makeDisc(count, center.x, center.y, 180.0f, 7, x, y, mass);
+
+        tree.theta = 0.7f;
+        tree.gravity = 2e6f / count;
+        tree.softening = 2.0f;
+        tree.build(x, y, mass);
+        tree.computeAccelerations(x, y, ax, ay, threads);
+
+        balls.reserve(count);
+        for (int i = 0; i < count; ++i)
+        {
+            float rx = x[i] - center.x;
+            float ry = y[i] - center.y;
+            float r = std::max(std::hypot(rx, ry), 1e-3f);
+            float radial = std::max(0.0f, -(ax[i] * rx + ay[i] * ry) / r);
+            float speed = std::sqrt(radial * r);
+            balls.emplace_back(x[i], y[i], 1.0f, -speed * ry / r, speed * rx / r, 0.0f, 0.0f, 0.5f);
+        }
+    }
+
+    void step(FrameRingWriter &ring) override
+    {
+        for (size_t i = 0; i < balls.size(); ++i)
+        {
+            x[i] = balls[i].x;
+            y[i] = balls[i].y;
+        }
+        tree.build(x, y, mass);
+        tree.computeAccelerations(x, y, ax, ay, threads);
+        Vec2 *frame = ring.beginFrame(balls.size());
+        for (size_t i = 0; i < balls.size(); ++i)
+        {
+            balls[i].ax = ax[i];
+            balls[i].ay = ay[i];
+            balls[i].update(static_cast<float>(FRAME_DT), boxBounds);
+            if (frame)
+                frame[i] = Vec2(balls[i].x, balls[i].y);
+        }
+    }
+
+    // the tree and the x, y, ax, ay scratch arrays are rebuilt from the balls every step
+    void save(SnapshotWriter &writer) const override
+    {
+        saveBalls(writer, balls);
+        writer.array("mass", mass);
+    }
+
+    bool load(SnapshotReader &reader) override
+    {
+        if (!loadBalls(reader, balls) || !reader.array("mass", mass) || mass.size() != balls.size())
+            return false;
+        x.resize(balls.size());
+        y.resize(balls.size());
+        return true;
+    }
+
+    bool createRing(FrameRingWriter &ring, const std::string &name) const override
+    {
+        return ring.create(name, "nbody", balls.size(), 0, 1.0f);
+    }
+
+    // step() wrote the frame, except for the one published before the first step
+    void publish(FrameRingWriter &ring, long long step) const override
+    {
+        if (ring.framePending())
+            ring.commitFrame(step);
+        else
+            publishBalls(ring, step, balls, threads);
+    }
+
+    void draw(Canvas &canvas) const override
+    {
+        canvas.clear({0, 0, 0});
+        canvas.rectOutline(boxBounds, 5, {255, 255, 255});
+        for (const auto &ball : balls)
+            canvas.fillCircle(Vec2(ball.x, ball.y), ball.radius, {255, 0, 0});
+    }
+
+private:
+    Box boxBounds;
+    int threads;
+    BarnesHutTree tree;
+    std::vector<Ball> balls;
+    std::vector<float> x, y, mass, ax, ay;
+};
+
+// the viewer's cloth, or with --count N an N x N one stepped with the multigrid solver
+class ClothRun : public HeadlessSimulation
+{
+public:
+    explicit ClothRun(int side) : side(side), multigrid(side, side), threads(hardwareThreads())
+    {
+        if (side > 0)
+            buildCloth(particles, constraints, side, side);
+        else
+            resetSimulation(particles, constraints);
+    }
+
+    void step(FrameRingWriter &ring) override
+    {
+        Vec2 *frame = ring.beginFrame(particles.size());
+        if (side > 0)
+            stepCloth(particles, constraints, multigrid, frame);
+        else
+            stepCloth(particles, constraints, frame);
+    }
+
+    void save(SnapshotWriter &writer) const override { saveCloth(writer, particles, constraints); }
+    bool load(SnapshotReader &reader) override { return loadCloth(reader, particles, constraints); }
+
+    // nothing in a headless run pins or tears, so the flags go out once
+    bool createRing(FrameRingWriter &ring, const std::string &name) const override
+    {
+        int cols = side > 0 ? side : COLS;
+        if (!ring.create(name, "cloth", particles.size(), cols, 3.0f))
+            return false;
+        publishClothFlags(ring, particles, constraints, cols);
+        return true;
+    }
+
+    void publish(FrameRingWriter &ring, long long step) const override
+    {
+        if (ring.framePending())
+            ring.commitFrame(step);
+        else
+            publishCloth(ring, step, particles, threads);
+    }
+
+    void draw(Canvas &canvas) const override
+    {
+        canvas.clear({50, 50, 50});
+        for (const auto &constraint : constraints)
+        {
+            if (constraint.isActive)
+                canvas.line(constraint.particle1->position, constraint.particle2->position, {255, 255, 255});
+        }
+        for (const auto &particle : particles)
+        {
+            Rgb color = particle.isPinned ? Rgb{0, 0, 255} : Rgb{200, 200, 200};
+            canvas.fillCircle(particle.position, 3, color);
+        }
+    }
+
+    int width() const override { return WIDTH; }
+    int height() const override { return HEIGHT; }
+
+private:
+    int side;
+    ClothMultigrid multigrid;
+    int threads;
+    std::vector<Particle> particles;
+    std::vector<Constraint> constraints;
+};
+
+class PendulumRun : public HeadlessSimulation
+{
+public:
+    void step(FrameRingWriter &) override { step_pendulum(state, 0.005, 10); }
+    void save(SnapshotWriter &writer) const override { save_pendulum(writer, state); }
+    bool load(SnapshotReader &reader) override { return load_pendulum(reader, state); }
+
+    void draw(Canvas &canvas) const override
+    {
+        Vec2 origin(400, 100);
+        Vec2 mass1(origin.x + L1 * sin(state.theta1), origin.y + L1 * cos(state.theta1));
+        Vec2 mass2(mass1.x + L2 * sin(state.theta2), mass1.y + L2 * cos(state.theta2));
+        canvas.clear({0, 0, 0});
+        canvas.line(origin, mass1, {255, 255, 255});
+        canvas.line(mass1, mass2, {255, 255, 255});
+        canvas.fillCircle(mass1, 10, {0, 0, 255});
+        canvas.fillCircle(mass2, 10, {0, 255, 0});
+    }
+
+private:
+    PendulumState state;
+};
+
+// the mouse is replaced by a target going round in a circle
+class SnakeRun : public HeadlessSimulation
+{
+public:
+    SnakeRun() : snake(10, 20.f) {}
+
+    void step(FrameRingWriter &) override
+    {
+        steps++;
+        float t = static_cast<float>(steps * FRAME_DT);
+        snake.update(static_cast<float>(FRAME_DT), Vec2(400 + 200 * std::cos(t), 300 + 150 * std::sin(t)));
+    }
+
+    void save(SnapshotWriter &writer) const override
+    {
+        writer.value("steps", steps);
+        saveSnake(writer, snake);
+    }
+
+    bool load(SnapshotReader &reader) override { return reader.value("steps", steps) && loadSnake(reader, snake); }
+
+    void draw(Canvas &canvas) const override
+    {
+        canvas.clear({0, 0, 0});
+        for (const auto &segment : snake.segments)
+        {
+            Vec2 along(std::cos(segment.angle), std::sin(segment.angle));
+            Vec2 across(-along.y, along.x);
+            Vec2 a = segment.position;
+            Vec2 b = a + along * segment.length;
+            canvas.fillQuad(a, b, b + across * 5.0f, a + across * 5.0f, {255, 255, 255});
+        }
+    }
+
+private:
+    Snake snake;
+    long long steps = 0;
+};
+
+class TentacleRun : public HeadlessSimulation
+{
+public:
+    explicit TentacleRun(int count) : batch(count, 10, 20.f), threads(hardwareThreads())
+    {
+        for (int c = 0; c < count; ++c)
+            batch.setRoot(c, 20.f + 760.f * (c + 0.5f) / count, 590.f);
+    }
+
+    void step(FrameRingWriter &) override
+    {
+        steps++;
+        float t = static_cast<float>(steps * FRAME_DT);
+        moveTargets(batch, t, Vec2(400 + 200 * std::cos(t), 300 + 100 * std::sin(t)), 9 * 20.f);
+        batch.solve(threads);
+    }
+
+    void save(SnapshotWriter &writer) const override
+    {
+        writer.value("steps", steps);
+        saveChains(writer, batch);
+    }
+
+    bool load(SnapshotReader &reader) override { return reader.value("steps", steps) && loadChains(reader, batch); }
+
+    void draw(Canvas &canvas) const override
+    {
+        canvas.clear({0, 0, 0});
+        int n = batch.chainCount;
+        for (int c = 0; c < n; ++c)
+            for (int j = 0; j + 1 < batch.jointCount; ++j)
+                canvas.line(Vec2(batch.x[j * n + c], batch.y[j * n + c]), Vec2(batch.x[(j + 1) * n + c], batch.y[(j + 1) * n + c]), {255, 255, 255});
+    }
+
+private:
+    ChainBatch batch;
+    int threads;
+    long long steps = 0;
+};
+
+std::unique_ptr<HeadlessSimulation> makeSimulation(const std::string &name, int count)
+{
+    if (name == "ball")
+        return std::make_unique<BallRun>(count > 0 ? count : 1);
+    if (name == "events" || name == "pile")
+        return std::make_unique<EventRun>(count > 0 ? count : 300, name == "pile");
+    if (name == "nbody")
+        return std::make_unique<NBodyRun>(count > 0 ? count : 20000);
+    if (name == "cloth")
+        return std::make_unique<ClothRun>(count);
+    if (name == "pendulum")
+        return std::make_unique<PendulumRun>();
+    if (name == "snake")
+        return std::make_unique<SnakeRun>();
+    if (name == "tentacles")
+        return std::make_unique<TentacleRun>(count > 0 ? count : 200);
+    return nullptr;
+}
+
+bool writeCheckpoint(const std::string &path, const std::string &name, int count, long long step, const HeadlessSimulation &sim)
+{
+    SnapshotWriter writer;
+    writer.run(name, step, count);
+    sim.save(writer);
+    return writer.writeFile(path);
+}
+
+// the value of a numeric option: digits only, no sign, no trailing text, no overflow
+bool parseCount(const char *text, long long &value)
+{
+    if (*text < '0' || *text > '9')
+        return false;
+    errno = 0;
+    char *end = nullptr;
+    value = std::strtoll(text, &end, 10);
+    return errno == 0 && *end == '\0';
+}
+
+void printUsage()
+{
+    std::fprintf(stderr,
+                 "usage: headless <ball|events|pile|nbody|cloth|pendulum|snake|tentacles> [--steps N] [--frames K] [--checkpoint K] [--out DIR] [--count N] [--publish NAME]\n"
+                 "       headless resume FILE [--steps N] [--frames K] [--checkpoint K] [--out DIR] [--publish NAME]\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    std::string name = argv[1];
+    bool resume = name == "resume";
+    if (resume && argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    long long steps = 600; // the step to stop at, counted from the start of the run even when resuming
+    long long frameEvery = 0;      // 0 = no frames
+    long long checkpointEvery = 0; // 0 = no checkpoints
+    std::string outDir = ".";
+    int count = 0; // 0 = the simulation's default
+    std::string publishName; // shared memory ring every step is published to, none if empty
+
+    // every option takes a value; a missing value, an unknown option or a number that is not one stops the run
+    // instead of silently running with the default
+    for (int i = resume ? 3 : 2; i < argc; i += 2)
+    {
+        const char *option = argv[i];
+        if (i + 1 == argc)
+        {
+            std::fprintf(stderr, "%s needs a value\n", option);
+            printUsage();
+            return 1;
+        }
+        const char *value = argv[i + 1];
+        long long number = 0;
+        bool numeric = std::strcmp(option, "--out") != 0 && std::strcmp(option, "--publish") != 0;
+        if (numeric && !parseCount(value, number))
+        {
+            std::fprintf(stderr, "%s needs a whole number >= 0, not %s\n", option, value);
+            return 1;
+        }
+
+        if (std::strcmp(option, "--steps") == 0)
+            steps = number;
+        else if (std::strcmp(option, "--frames") == 0)
+            frameEvery = number;
+        else if (std::strcmp(option, "--checkpoint") == 0)
+            checkpointEvery = number;
+        else if (std::strcmp(option, "--out") == 0)
+            outDir = value;
+        else if (std::strcmp(option, "--count") == 0 && !resume && number <= std::numeric_limits<int>::max())
+            count = static_cast<int>(number);
+        else if (std::strcmp(option, "--publish") == 0)
+            publishName = value;
+        else
+        {
+            if (std::strcmp(option, "--count") == 0)
+                std::fprintf(stderr, resume ? "--count is taken from the checkpoint when resuming\n" : "--count %s is too large\n", value);
+            else
+                std::fprintf(stderr, "unknown option %s\n", option);
+            printUsage();
+            return 1;
+        }
+    }
+
+    // a resumed run is built like a fresh one and then overwritten with the checkpoint,
+    // after which it continues bit for bit like the run that wrote it
+    std::unique_ptr<HeadlessSimulation> sim;
+    long long firstStep = 1;
+    if (resume)
+    {
+        SnapshotReader reader;
+        RunInfo info;
+        if (!reader.open(argv[2]) || !reader.run(info))
+        {
+            std::fprintf(stderr, "%s is not a checkpoint\n", argv[2]);
+            return 1;
+        }
+        name = info.name;
+        count = info.count;
+        sim = makeSimulation(name, count);
+        if (!sim || !sim->load(reader))
+        {
+            std::fprintf(stderr, "could not restore %s from %s\n", name.c_str(), argv[2]);
+            return 1;
+        }
+        firstStep = info.step + 1;
+    }
+    else
+    {
+        sim = makeSimulation(name, count);
+    }
+    if (!sim)
+    {
+        printUsage();
+        return 1;
+    }
+
+    FrameRingWriter ring;
+    if (!publishName.empty())
+    {
+        if (!sim->createRing(ring, publishName))
+        {
+            std::fprintf(stderr, "could not publish %s to shared memory %s\n", name.c_str(), frameRingPath(publishName).c_str());
+            return 1;
+        }
+        // a viewer attaching before the first step has something to show
+        sim->publish(ring, firstStep - 1);
+    }
+
+    Canvas canvas(sim->width(), sim->height());
+    int framesWritten = 0;
+    int checkpointsWritten = 0;
+    double drawSeconds = 0.0;
+    double publishSeconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long long step = firstStep; step <= steps; ++step)
+    {
+        sim->step(ring);
+
+        if (ring.isOpen())
+        {
+            auto publishStart = std::chrono::steady_clock::now();
+            sim->publish(ring, step);
+            publishSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - publishStart).count();
+        }
+
+        if (frameEvery > 0 && step % frameEvery == 0)
+        {
+            auto drawStart = std::chrono::steady_clock::now();
+            char path[512];
+            std::snprintf(path, sizeof(path), "%s/%s_%08lld.ppm", outDir.c_str(), name.c_str(), step);
+            sim->draw(canvas);
+            if (!canvas.writePPM(path))
+            {
+                std::fprintf(stderr, "could not write %s\n", path);
+                return 1;
+            }
+            framesWritten++;
+            drawSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - drawStart).count();
+        }
+
+        if (checkpointEvery > 0 && step % checkpointEvery == 0)
+        {
+            char path[512];
+            std::snprintf(path, sizeof(path), "%s/%s_%08lld.snap", outDir.c_str(), name.c_str(), step);
+            if (!writeCheckpoint(path, name, count, step, *sim))
+            {
+                std::fprintf(stderr, "could not write %s\n", path);
+                return 1;
+            }
+            checkpointsWritten++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long stepped = std::max(0LL, steps - firstStep + 1);
+    std::printf("%s: %lld steps in %.3f s (%.0f steps/s), %d frames written (%.3f s), %d checkpoints written\n",
+                name.c_str(), stepped, seconds, seconds > 0.0 ? stepped / seconds : 0.0, framesWritten, drawSeconds, checkpointsWritten);
+    if (ring.isOpen())
+        std::printf("published every step to %s, %.3f s in total, %.1f us per step\n",
+                    frameRingPath(publishName).c_str(), publishSeconds, stepped > 0 ? 1e6 * publishSeconds / stepped : 0.0);
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "raster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    // float to int clamped to [lo, hi] first: casting a NaN or a value beyond int's range (an exploded simulation)
+    // is undefined. NaN comes out as lo, which leaves the ranges below empty and plot() off the canvas
+    int toPixel(float value, int lo, int hi)
+    {
+        if (!(value >= static_cast<float>(lo)))
+            return lo;
+        if (value >= static_cast<float>(hi))
+            return hi;
+        return static_cast<int>(value);
+    }
+}
+
+Canvas::Canvas(int width, int height) : width(width), height(height), pixels(static_cast<size_t>(width) * height * 3, 0) {}
+
+void Canvas::clear(Rgb color)
+{
+    for (size_t i = 0; i < pixels.size(); i += 3)
+    {
+        pixels[i] = color.r;
+        pixels[i + 1] = color.g;
+        pixels[i + 2] = color.b;
+    }
+}
+
+// DDA, one pixel per step along the longer axis
+void Canvas::line(Vec2 a, Vec2 b, Rgb color)
+{
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    // lines far outside the canvas (exploded simulations) would take forever to walk
+    int steps = toPixel(std::ceil(std::max(std::abs(dx), std::abs(dy))), 0, 4 * (width + height));
+    if (steps == 0)
+    {
+        plot(toPixel(a.x, -1, width), toPixel(a.y, -1, height), color);
+        return;
+    }
+    float sx = dx / steps;
+    float sy = dy / steps;
+    float x = a.x;
+    float y = a.y;
+    for (int i = 0; i <= steps; ++i)
+    {
+        plot(toPixel(std::floor(x), -1, width), toPixel(std::floor(y), -1, height), color);
+        x += sx;
+        y += sy;
+    }
+}
+
+void Canvas::fillCircle(Vec2 center, float radius, Rgb color)
+{
+    int x0 = toPixel(std::floor(center.x - radius), 0, width);
+    int x1 = toPixel(std::ceil(center.x + radius), -1, width - 1);
+    int y0 = toPixel(std::floor(center.y - radius), 0, height);
+    int y1 = toPixel(std::ceil(center.y + radius), -1, height - 1);
+    float radiusSq = radius * radius;
+    if (x0 > x1 || y0 > y1)
+        return; // off canvas
+    bool any = false;
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            float px = x + 0.5f - center.x;
+            float py = y + 0.5f - center.y;
+            if (px * px + py * py <= radiusSq)
+            {
+                plot(x, y, color);
+                any = true;
+            }
+        }
+    }
+    // a circle smaller than a pixel still shows up as one
+    if (!any)
+        plot(toPixel(center.x, -1, width), toPixel(center.y, -1, height), color);
+}
+
+void Canvas::fillRect(const Box &rect, Rgb color)
+{
+    int x0 = toPixel(std::floor(rect.left), 0, width);
+    int x1 = toPixel(std::ceil(rect.left + rect.width), 0, width);
+    int y0 = toPixel(std::floor(rect.top), 0, height);
+    int y1 = toPixel(std::ceil(rect.top + rect.height), 0, height);
+    for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+            plot(x, y, color);
+}
+
+// pixel centres inside all four edges, tested with edge functions over the bounding box
+void Canvas::fillQuad(Vec2 a, Vec2 b, Vec2 c, Vec2 d, Rgb color)
+{
+    const Vec2 corners[4] = {a, b, c, d};
+    float minX = a.x, maxX = a.x, minY = a.y, maxY = a.y;
+    for (const Vec2 &p : corners)
+    {
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+    int x0 = toPixel(std::floor(minX), 0, width);
+    int x1 = toPixel(std::ceil(maxX), -1, width - 1);
+    int y0 = toPixel(std::floor(minY), 0, height);
+    int y1 = toPixel(std::ceil(maxY), -1, height - 1);
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            float px = x + 0.5f;
+            float py = y + 0.5f;
+            bool allPositive = true, allNegative = true;
+            for (int e = 0; e < 4; ++e)
+            {
+                const Vec2 &p0 = corners[e];
+                const Vec2 &p1 = corners[(e + 1) % 4];
+                float side = (p1.x - p0.x) * (py - p0.y) - (p1.y - p0.y) * (px - p0.x);
+                allPositive = allPositive && side >= 0.0f;
+                allNegative = allNegative && side <= 0.0f;
+            }
+            if (allPositive || allNegative)
+                plot(x, y, color);
+        }
+    }
+}
+
+// outside the rectangle, like BatchRenderer::rectOutline
+void Canvas::rectOutline(const Box &rect, float thickness, Rgb color)
+{
+    float t = thickness;
+    fillRect(Box(rect.left - t, rect.top - t, rect.width + 2 * t, t), color);
+    fillRect(Box(rect.left - t, rect.top + rect.height, rect.width + 2 * t, t), color);
+    fillRect(Box(rect.left - t, rect.top, t, rect.height), color);
+    fillRect(Box(rect.left + rect.width, rect.top, t, rect.height), color);
+}
+
+bool Canvas::writePPM(const std::string &path) const
+{
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    bool ok = std::fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+    return std::fclose(file) == 0 && ok;
+}
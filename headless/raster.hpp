@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../common/vec2.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// minimal software rasterizer for the headless runner
+// sf::RenderTexture needs an OpenGL context, which display-less servers don't have, so frames are drawn on the CPU
+// into an RGB buffer and written out as binary PPM (P6), which any image tool can convert
+
+struct Rgb
+{
+    std::uint8_t r, g, b;
+};
+
+class Canvas
+{
+public:
+    int width, height;
+    std::vector<std::uint8_t> pixels; // RGB, row major
+
+    Canvas(int width, int height);
+
+    void clear(Rgb color);
+    void line(Vec2 a, Vec2 b, Rgb color);
+    void fillCircle(Vec2 center, float radius, Rgb color);
+    void fillRect(const Box &rect, Rgb color);
+    // convex quad, corners in order (either winding)
+    void fillQuad(Vec2 a, Vec2 b, Vec2 c, Vec2 d, Rgb color);
+    void rectOutline(const Box &rect, float thickness, Rgb color);
+
+    bool writePPM(const std::string &path) const;
+
+private:
+    void plot(int x, int y, Rgb color)
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            return;
+        std::uint8_t *p = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+        p[0] = color.r;
+        p[1] = color.g;
+        p[2] = color.b;
+    }
+};
@@ -1,97 +1,25 @@
+#include "../renderer/renderer.hpp"
+#include "pendulum.hpp"
 #include <iostream>
 #include <SFML/Graphics.hpp>
 #include <cmath>
 #include <vector>
 #include <sstream>
 
-const double g = 9.81;
-const double L1 = 200;
-const double L2 = 200;
-const double m1 = 10.0;
-const double m2 = 10.0;
-double theta1 = M_PI / 6;
-double theta2 = M_PI / 6;
-double omega1 = 0.0;
-double omega2 = 0.0;
-double dt = 0.005;
-
-void derivatives(double &theta1, double &omega1, double &theta2, double &omega2, double &omega1_dot, double &omega2_dot)
-{
-    double delta = theta2 - theta1;
-    double denominator = (2 * m1 + m2) - m2 * cos(2 * delta);
-    double numerator1 = -g * (2 * m1 + m2) * sin(theta1) - m2 * g * sin(theta1 - 2 * theta2) - 2 * sin(delta) * m2 * (omega2 * omega2 * L2 + omega1 * omega1 * L1 * cos(delta));
-    double denom1 = L1 * denominator;
-    omega1_dot = numerator1 / denom1;
-    double numerator2 = 2 * sin(delta) * (omega1 * omega1 * L1 * (m1 + m2) + g * (m1 + m2) * cos(theta1) + omega2 * omega2 * L2 * m2 * cos(delta));
-    double denom2 = L2 * denominator;
-    omega2_dot = numerator2 / denom2;
-}
-
-void rk4_step(double &theta1, double &omega1, double &theta2, double &omega2, double dt)
-{
-    double k1_theta1 = omega1;
-    double k1_theta2 = omega2;
-    double k1_omega1, k1_omega2;
-    derivatives(theta1, omega1, theta2, omega2, k1_omega1, k1_omega2);
-
-    double theta1_mid = theta1 + 0.5 * dt * k1_theta1;
-    double omega1_mid = omega1 + 0.5 * dt * k1_omega1;
-    double theta2_mid = theta2 + 0.5 * dt * k1_theta2;
-    double omega2_mid = omega2 + 0.5 * dt * k1_omega2;
-
-    double k2_theta1 = omega1_mid;
-    double k2_theta2 = omega2_mid;
-    double k2_omega1, k2_omega2;
-    derivatives(theta1_mid, omega1_mid, theta2_mid, omega2_mid, k2_omega1, k2_omega2);
-
-    theta1_mid = theta1 + 0.5 * dt * k2_theta1;
-    omega1_mid = omega1 + 0.5 * dt * k2_omega1;
-    theta2_mid = theta2 + 0.5 * dt * k2_theta2;
-    omega2_mid = omega2 + 0.5 * dt * k2_omega2;
-
-    double k3_theta1 = omega1_mid;
-    double k3_theta2 = omega2_mid;
-    double k3_omega1, k3_omega2;
-    derivatives(theta1_mid, omega1_mid, theta2_mid, omega2_mid, k3_omega1, k3_omega2);
-
-    double theta1_end = theta1 + dt * k3_theta1;
-    double omega1_end = omega1 + dt * k3_omega1;
-    double theta2_end = theta2 + dt * k3_theta2;
-    double omega2_end = omega2 + dt * k3_omega2;
-
-    double k4_theta1 = omega1_end;
-    double k4_theta2 = omega2_end;
-    double k4_omega1, k4_omega2;
-    derivatives(theta1_end, omega1_end, theta2_end, omega2_end, k4_omega1, k4_omega2);
-
-    theta1 += (dt / 6.0) * (k1_theta1 + 2.0 * k2_theta1 + 2.0 * k3_theta1 + k4_theta1);
-    omega1 += (dt / 6.0) * (k1_omega1 + 2.0 * k2_omega1 + 2.0 * k3_omega1 + k4_omega1);
-    theta2 += (dt / 6.0) * (k1_theta2 + 2.0 * k2_theta2 + 2.0 * k3_theta2 + k4_theta2);
-    omega2 += (dt / 6.0) * (k1_omega2 + 2.0 * k2_omega2 + 2.0 * k3_omega2 + k4_omega2);
-}
-
-double calculate_kinetic_energy(double theta1, double omega1, double theta2, double omega2)
-{
-    double T1 = 0.5 * m1 * L1 * L1 * omega1 * omega1;
-    double T2 = 0.5 * m2 * (L1 * L1 * omega1 * omega1 + L2 * L2 * omega2 * omega2 + 2 * L1 * L2 * omega1 * omega2 * cos(theta1 - theta2));
-    return T1 + T2;
-}
+// viewer, the physics is in pendulum.hpp
 
-double calculate_potential_energy(double theta1, double theta2)
-{
-    double V1 = -m1 * g * L1 * cos(theta1);
-    double V2 = -m2 * g * (L1 * cos(theta1) + L2 * cos(theta2));
-    return V1 + V2;
-}
+// built by the top level CMakeLists.txt when SFML is found
 
 int main()
 {
     sf::RenderWindow window(sf::VideoMode(800, 600), "Double Pendulum Simulation");
     sf::Vector2f origin(400, 100);
-    std::vector<sf::Vertex> trajectory;
+    std::vector<sf::Vector2f> trajectory;
+    PendulumState state;
+    double dt = 0.005;
 
-    sf::Font font;
-    if (!font.loadFromFile("Arial.ttf"))
+    BatchRenderer renderer;
+    if (!renderer.loadFont("Arial.ttf"))
     {
         std::cerr << "Error loading font\n";
         return -1;
@@ -109,57 +37,41 @@ int main()
         // rk4_step(theta1, omega1, theta2, omega2, dt);
         // trying with multiple rk4 steps per frame
         int sub_steps = 10;
-        for (int i = 0; i < sub_steps; i++)
-        {
-            rk4_step(theta1, omega1, theta2, omega2, dt / sub_steps);
-        }
+        step_pendulum(state, dt, sub_steps);
 
-        double x1 = origin.x + L1 * sin(theta1);
-        double y1 = origin.y + L1 * cos(theta1);
-        double x2 = x1 + L2 * sin(theta2);
-        double y2 = y1 + L2 * cos(theta2);
+        double x1 = origin.x + L1 * sin(state.theta1);
+        double y1 = origin.y + L1 * cos(state.theta1);
+        double x2 = x1 + L2 * sin(state.theta2);
+        double y2 = y1 + L2 * cos(state.theta2);
 
-        trajectory.emplace_back(sf::Vector2f(x2, y2), sf::Color::Red);
+        trajectory.emplace_back(x2, y2);
         if (trajectory.size() > 1000)
             trajectory.erase(trajectory.begin());
 
-        double T = calculate_kinetic_energy(theta1, omega1, theta2, omega2);
-        double V = calculate_potential_energy(theta1, theta2);
+        double T = calculate_kinetic_energy(state.theta1, state.omega1, state.theta2, state.omega2);
+        double V = calculate_potential_energy(state.theta1, state.theta2);
         double E = T + V;
 
-        window.clear();
-
-        if (trajectory.size() > 1)
-            window.draw(&trajectory[0], trajectory.size(), sf::LinesStrip);
+        renderer.begin();
 
-        sf::VertexArray rods(sf::LinesStrip, 3);
-        rods[0].position = origin;
-        rods[1].position = sf::Vector2f(x1, y1);
-        rods[2].position = sf::Vector2f(x2, y2);
-        window.draw(rods);
+        renderer.lineStrip(trajectory.data(), trajectory.size(), sf::Color::Red);
 
-        sf::CircleShape mass1(10);
-        mass1.setOrigin(10, 10);
-        mass1.setPosition(x1, y1);
-        mass1.setFillColor(sf::Color::Blue);
-        window.draw(mass1);
+        sf::Vector2f mass1(x1, y1);
+        sf::Vector2f mass2(x2, y2);
+        renderer.line(origin, mass1, sf::Color::White);
+        renderer.line(mass1, mass2, sf::Color::White);
 
-        sf::CircleShape mass2(10);
-        mass2.setOrigin(10, 10);
-        mass2.setPosition(x2, y2);
-        mass2.setFillColor(sf::Color::Green);
-        window.draw(mass2);
+        renderer.circle(mass1, 10, sf::Color::Blue);
+        renderer.circle(mass2, 10, sf::Color::Green);
 
         std::ostringstream energyDisplay;
         energyDisplay << "Total Energy = " << E << "\n";
         energyDisplay << "Kinetic Energy = " << T << "\n";
         energyDisplay << "Potential Energy = " << V << "\n";
+        renderer.text(0, energyDisplay.str(), sf::Vector2f(10, 10), 15, sf::Color::White);
 
-        sf::Text energyText(energyDisplay.str(), font, 15);
-        energyText.setPosition(10, 10);
-        energyText.setFillColor(sf::Color::White);
-        window.draw(energyText);
-
+        window.clear();
+        renderer.flush(window);
         window.display();
     }
 
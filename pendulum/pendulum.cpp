@@ -0,0 +1,88 @@
+#include "pendulum.hpp"
+
+void derivatives(double &theta1, double &omega1, double &theta2, double &omega2, double &omega1_dot, double &omega2_dot)
+{
+    double delta = theta2 - theta1;
+    double denominator = (2 * m1 + m2) - m2 * cos(2 * delta);
+    double numerator1 = -g * (2 * m1 + m2) * sin(theta1) - m2 * g * sin(theta1 - 2 * theta2) - 2 * sin(delta) * m2 * (omega2 * omega2 * L2 + omega1 * omega1 * L1 * cos(delta));
+    double denom1 = L1 * denominator;
+    omega1_dot = numerator1 / denom1;
+    double numerator2 = 2 * sin(delta) * (omega1 * omega1 * L1 * (m1 + m2) + g * (m1 + m2) * cos(theta1) + omega2 * omega2 * L2 * m2 * cos(delta));
+    double denom2 = L2 * denominator;
+    omega2_dot = numerator2 / denom2;
+}
+
+void rk4_step(double &theta1, double &omega1, double &theta2, double &omega2, double dt)
+{
+    double k1_theta1 = omega1;
+    double k1_theta2 = omega2;
+    double k1_omega1, k1_omega2;
+    derivatives(theta1, omega1, theta2, omega2, k1_omega1, k1_omega2);
+
+    double theta1_mid = theta1 + 0.5 * dt * k1_theta1;
+    double omega1_mid = omega1 + 0.5 * dt * k1_omega1;
+    double theta2_mid = theta2 + 0.5 * dt * k1_theta2;
+    double omega2_mid = omega2 + 0.5 * dt * k1_omega2;
+
+    double k2_theta1 = omega1_mid;
+    double k2_theta2 = omega2_mid;
+    double k2_omega1, k2_omega2;
+    derivatives(theta1_mid, omega1_mid, theta2_mid, omega2_mid, k2_omega1, k2_omega2);
+
+    theta1_mid = theta1 + 0.5 * dt * k2_theta1;
+    omega1_mid = omega1 + 0.5 * dt * k2_omega1;
+    theta2_mid = theta2 + 0.5 * dt * k2_theta2;
+    omega2_mid = omega2 + 0.5 * dt * k2_omega2;
+
+    double k3_theta1 = omega1_mid;
+    double k3_theta2 = omega2_mid;
+    double k3_omega1, k3_omega2;
+    derivatives(theta1_mid, omega1_mid, theta2_mid, omega2_mid, k3_omega1, k3_omega2);
+
+    double theta1_end = theta1 + dt * k3_theta1;
+    double omega1_end = omega1 + dt * k3_omega1;
+    double theta2_end = theta2 + dt * k3_theta2;
+    double omega2_end = omega2 + dt * k3_omega2;
+
+    double k4_theta1 = omega1_end;
+    double k4_theta2 = omega2_end;
+    double k4_omega1, k4_omega2;
+    derivatives(theta1_end, omega1_end, theta2_end, omega2_end, k4_omega1, k4_omega2);
+
+    theta1 += (dt / 6.0) * (k1_theta1 + 2.0 * k2_theta1 + 2.0 * k3_theta1 + k4_theta1);
+    omega1 += (dt / 6.0) * (k1_omega1 + 2.0 * k2_omega1 + 2.0 * k3_omega1 + k4_omega1);
+    theta2 += (dt / 6.0) * (k1_theta2 + 2.0 * k2_theta2 + 2.0 * k3_theta2 + k4_theta2);
+    omega2 += (dt / 6.0) * (k1_omega2 + 2.0 * k2_omega2 + 2.0 * k3_omega2 + k4_omega2);
+}
+
+double calculate_kinetic_energy(double theta1, double omega1, double theta2, double omega2)
+{
+    double T1 = 0.5 * m1 * L1 * L1 * omega1 * omega1;
+    double T2 = 0.5 * m2 * (L1 * L1 * omega1 * omega1 + L2 * L2 * omega2 * omega2 + 2 * L1 * L2 * omega1 * omega2 * cos(theta1 - theta2));
+    return T1 + T2;
+}
+
+double calculate_potential_energy(double theta1, double theta2)
+{
+    double V1 = -m1 * g * L1 * cos(theta1);
+    double V2 = -m2 * g * (L1 * cos(theta1) + L2 * cos(theta2));
+    return V1 + V2;
+}
+
+void step_pendulum(PendulumState &state, double dt, int sub_steps)
+{
+    for (int i = 0; i < sub_steps; i++)
+    {
+        rk4_step(state.theta1, state.omega1, state.theta2, state.omega2, dt / sub_steps);
+    }
+}
+
+void save_pendulum(SnapshotWriter &writer, const PendulumState &state)
+{
+    writer.value("pendulum", state);
+}
+
+bool load_pendulum(SnapshotReader &reader, PendulumState &state)
+{
+    return reader.value("pendulum", state);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../common/snapshot.hpp"
+#include <cmath>
+
+// double pendulum physics, no SFML in here so it can be used by the viewer, the headless runner and the benchmarks
+
+const double g = 9.81;
+const double L1 = 200;
+const double L2 = 200;
+const double m1 = 10.0;
+const double m2 = 10.0;
+
+struct PendulumState
+{
+    double theta1 = M_PI / 6;
+    double theta2 = M_PI / 6;
+    double omega1 = 0.0;
+    double omega2 = 0.0;
+};
+
+void derivatives(double &theta1, double &omega1, double &theta2, double &omega2, double &omega1_dot, double &omega2_dot);
+void rk4_step(double &theta1, double &omega1, double &theta2, double &omega2, double dt);
+double calculate_kinetic_energy(double theta1, double omega1, double theta2, double omega2);
+double calculate_potential_energy(double theta1, double theta2);
+
+// one frame: dt split into sub_steps rk4 steps
+void step_pendulum(PendulumState &state, double dt, int sub_steps);
+
+// the four numbers of PendulumState are the whole state, restoring them continues the exact same trajectory
+void save_pendulum(SnapshotWriter &writer, const PendulumState &state);
+bool load_pendulum(SnapshotReader &reader, PendulumState &state);
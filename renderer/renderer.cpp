@@ -0,0 +1,171 @@
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const unsigned CIRCLE_TEXTURE_SIZE = 64;
+}
+
+BatchRenderer::BatchRenderer() : lines(sf::Lines), quads(sf::Triangles), circles(sf::Triangles)
+{
+    // white disc with a one texel soft edge, the vertex colour tints it
+    sf::Image image;
+    image.create(CIRCLE_TEXTURE_SIZE, CIRCLE_TEXTURE_SIZE, sf::Color::Transparent);
+    float center = CIRCLE_TEXTURE_SIZE / 2.0f;
+    for (unsigned y = 0; y < CIRCLE_TEXTURE_SIZE; ++y)
+    {
+        for (unsigned x = 0; x < CIRCLE_TEXTURE_SIZE; ++x)
+        {
+            float dist = std::hypot(x + 0.5f - center, y + 0.5f - center);
+            float alpha = std::clamp(center - dist, 0.0f, 1.0f);
+            image.setPixel(x, y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(alpha * 255)));
+        }
+    }
+    circleTexture.loadFromImage(image);
+    circleTexture.setSmooth(true);
+}
+
+bool BatchRenderer::loadFont(const std::string &path)
+{
+    hasFont = font.loadFromFile(path);
+    return hasFont;
+}
+
+void BatchRenderer::begin()
+{
+    lines.vertices.clear();
+    quads.vertices.clear();
+    circles.vertices.clear();
+    for (auto &cached : texts)
+        cached.used = false;
+}
+
+void BatchRenderer::line(sf::Vector2f a, sf::Vector2f b, sf::Color color)
+{
+    lines.vertices.emplace_back(a, color);
+    lines.vertices.emplace_back(b, color);
+}
+
+void BatchRenderer::lineStrip(const sf::Vector2f *points, size_t count, sf::Color color)
+{
+    for (size_t i = 1; i < count; ++i)
+        line(points[i - 1], points[i], color);
+}
+
+void BatchRenderer::quad(sf::Vector2f position, sf::Vector2f size, sf::Color color)
+{
+    sf::Vector2f a = position;
+    sf::Vector2f b(position.x + size.x, position.y);
+    sf::Vector2f c = position + size;
+    sf::Vector2f d(position.x, position.y + size.y);
+    auto &v = quads.vertices;
+    v.emplace_back(a, color);
+    v.emplace_back(b, color);
+    v.emplace_back(c, color);
+    v.emplace_back(a, color);
+    v.emplace_back(c, color);
+    v.emplace_back(d, color);
+}
+
+void BatchRenderer::rotatedQuad(sf::Vector2f origin, sf::Vector2f size, float angle, sf::Color color)
+{
+    sf::Vector2f along(std::cos(angle), std::sin(angle));
+    sf::Vector2f across(-along.y, along.x);
+    sf::Vector2f a = origin;
+    sf::Vector2f b = origin + along * size.x;
+    sf::Vector2f c = b + across * size.y;
+    sf::Vector2f d = origin + across * size.y;
+    auto &v = quads.vertices;
+    v.emplace_back(a, color);
+    v.emplace_back(b, color);
+    v.emplace_back(c, color);
+    v.emplace_back(a, color);
+    v.emplace_back(c, color);
+    v.emplace_back(d, color);
+}
+
+// the outline sits outside the rectangle, like sf::Shape::setOutlineThickness with a positive thickness
+void BatchRenderer::rectOutline(sf::FloatRect rect, float thickness, sf::Color color)
+{
+    float t = thickness;
+    quad(sf::Vector2f(rect.left - t, rect.top - t), sf::Vector2f(rect.width + 2 * t, t), color);
+    quad(sf::Vector2f(rect.left - t, rect.top + rect.height), sf::Vector2f(rect.width + 2 * t, t), color);
+    quad(sf::Vector2f(rect.left - t, rect.top), sf::Vector2f(t, rect.height), color);
+    quad(sf::Vector2f(rect.left + rect.width, rect.top), sf::Vector2f(t, rect.height), color);
+}
+
+void BatchRenderer::circle(sf::Vector2f center, float radius, sf::Color color)
+{
+    const float s = static_cast<float>(CIRCLE_TEXTURE_SIZE);
+    sf::Vertex a(sf::Vector2f(center.x - radius, center.y - radius), color, sf::Vector2f(0, 0));
+    sf::Vertex b(sf::Vector2f(center.x + radius, center.y - radius), color, sf::Vector2f(s, 0));
+    sf::Vertex c(sf::Vector2f(center.x + radius, center.y + radius), color, sf::Vector2f(s, s));
+    sf::Vertex d(sf::Vector2f(center.x - radius, center.y + radius), color, sf::Vector2f(0, s));
+    auto &v = circles.vertices;
+    v.push_back(a);
+    v.push_back(b);
+    v.push_back(c);
+    v.push_back(a);
+    v.push_back(c);
+    v.push_back(d);
+}
+
+void BatchRenderer::text(int slot, const std::string &string, sf::Vector2f position, unsigned size, sf::Color color)
+{
+    if (!hasFont || slot < 0)
+        return;
+    if (slot >= static_cast<int>(texts.size()))
+        texts.resize(slot + 1);
+
+    CachedText &cached = texts[slot];
+    if (cached.text.getFont() == nullptr)
+        cached.text.setFont(font);
+    // setString re-lays out every glyph, skip it when nothing changed
+    if (cached.string != string)
+    {
+        cached.string = string;
+        cached.text.setString(string);
+    }
+    cached.text.setCharacterSize(size);
+    cached.text.setFillColor(color);
+    cached.text.setPosition(position);
+    cached.used = true;
+}
+
+void BatchRenderer::Batch::draw(sf::RenderTarget &target, const sf::RenderStates &states)
+{
+    if (vertices.empty())
+        return;
+
+    // no vertex buffer support (old GL drivers), draw straight from the CPU array
+    if (!sf::VertexBuffer::isAvailable())
+    {
+        target.draw(vertices.data(), vertices.size(), type, states);
+        return;
+    }
+
+    // grow in powers of two so the GPU buffer is only reallocated a handful of times
+    if (vertices.size() > capacity)
+    {
+        capacity = std::max<size_t>(1024, capacity);
+        while (capacity < vertices.size())
+            capacity *= 2;
+        buffer.create(capacity);
+    }
+    buffer.update(vertices.data(), vertices.size(), 0);
+    target.draw(buffer, 0, vertices.size(), states);
+}
+
+void BatchRenderer::flush(sf::RenderTarget &target)
+{
+    quads.draw(target, sf::RenderStates::Default);
+    lines.draw(target, sf::RenderStates::Default);
+    circles.draw(target, sf::RenderStates(&circleTexture));
+    for (const auto &cached : texts)
+    {
+        if (cached.used)
+            target.draw(cached.text);
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../common/vec2.hpp"
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+// shared batched renderer for all the simulations
+//
+// creating an sf::CircleShape / sf::RectangleShape / sf::Text per object per frame and drawing them one by one
+// costs a draw call (and for text a glyph layout) per object, which is what limits frame time long before the physics does.
+// instead, every primitive of a frame is appended to a CPU side vertex array, uploaded once into a persistent
+// sf::VertexBuffer, and drawn with one call per primitive type:
+//   - lines         sf::Lines
+//   - quads         two triangles each, axis aligned or rotated
+//   - circles       textured quads sampling one anti-aliased disc texture, tinted by the vertex colour
+//   - text          sf::Text objects cached per slot, the layout is only rebuilt when the string changes
+//
+// usage per frame: begin(), add primitives, flush(target). draw order is quads, lines, circles, text.
+// the vertex arrays and buffers keep their capacity between frames so there are no per frame allocations.
+
+class BatchRenderer
+{
+public:
+    BatchRenderer();
+
+    bool loadFont(const std::string &path);
+
+    void begin();
+
+    void line(sf::Vector2f a, sf::Vector2f b, sf::Color color);
+    // consecutive points joined by lines
+    void lineStrip(const sf::Vector2f *points, size_t count, sf::Color color);
+
+    void quad(sf::Vector2f position, sf::Vector2f size, sf::Color color);
+    // rectangle with its top left corner at origin, rotated by angle (radians) about it
+    void rotatedQuad(sf::Vector2f origin, sf::Vector2f size, float angle, sf::Color color);
+    void rectOutline(sf::FloatRect rect, float thickness, sf::Color color);
+
+    void circle(sf::Vector2f center, float radius, sf::Color color);
+
+    // slot identifies a text that stays on screen across frames (a label, a readout)
+    void text(int slot, const std::string &string, sf::Vector2f position, unsigned size, sf::Color color);
+
+    void flush(sf::RenderTarget &target);
+
+private:
+    struct Batch
+    {
+        sf::PrimitiveType type;
+        std::vector<sf::Vertex> vertices;
+        sf::VertexBuffer buffer;
+        size_t capacity = 0;
+
+        explicit Batch(sf::PrimitiveType type) : type(type), buffer(type, sf::VertexBuffer::Stream) {}
+        void draw(sf::RenderTarget &target, const sf::RenderStates &states);
+    };
+
+    struct CachedText
+    {
+        sf::Text text;
+        std::string string;
+        bool used = false;
+    };
+
+    Batch lines;
+    Batch quads;
+    Batch circles;
+    sf::Texture circleTexture;
+    sf::Font font;
+    bool hasFont = false;
+    std::vector<CachedText> texts;
+};
+
+// the physics cores use Vec2 / Box so they build without SFML
+inline sf::Vector2f toSf(const Vec2 &v) { return sf::Vector2f(v.x, v.y); }
+inline sf::FloatRect toSf(const Box &b) { return sf::FloatRect(b.left, b.top, b.width, b.height); }
+inline Vec2 toVec2(const sf::Vector2f &v) { return Vec2(v.x, v.y); }
@@ -1,73 +1,87 @@
+#include "../renderer/renderer.hpp"
+#include "snake.hpp"
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 
-struct Segment
-{
-    sf::Vector2f position;
-    float angle;
-    float length;
+// viewer, the physics is in snake.hpp
 
-    // Constructor
-    Segment(sf::Vector2f pos, float ang, float len)
-        : position(pos), angle(ang), length(len) {}
-};
+// built by the top level CMakeLists.txt when SFML is found
 
-class Snake
-{
-public:
-    std::vector<Segment> segments;
-    float amplitude = 20.f;
-    float frequency = 0.5f;
-    float speed = 100.f;
+// ./main                  one snake following the mouse
+// ./main --tentacles 200  200 anchored chains solved with batched FABRIK
 
-    Snake(int numSegments, float segmentLength)
+void renderSnake(BatchRenderer &renderer, const Snake &snake)
+{
+    for (const auto &segment : snake.segments)
     {
-        for (int i = 0; i < numSegments; ++i)
-        {
-            segments.emplace_back(sf::Vector2f(400, 300 - i * segmentLength), 0, segmentLength);
-        }
+        renderer.rotatedQuad(toSf(segment.position), sf::Vector2f(segment.length, 5), segment.angle, sf::Color::White);
     }
+}
+
+// a field of tentacles rooted along the bottom of the window, all reaching for the mouse
+int runTentacles(int chainCount)
+{
+    sf::RenderWindow window(sf::VideoMode(800, 600), "Tentacles with FABRIK");
 
-    void update(float deltaTime, sf::Vector2f target)
+    const int joints = 10;
+    const float segmentLength = 20.f;
+    const int threads = hardwareThreads();
+
+    ChainBatch batch(chainCount, joints, segmentLength);
+    for (int c = 0; c < chainCount; ++c)
+        batch.setRoot(c, 20.f + 760.f * (c + 0.5f) / chainCount, 590.f);
+
+    BatchRenderer renderer;
+    sf::Clock clock;
+    float time = 0.f;
+
+    while (window.isOpen())
     {
-        // FK: Sinusoidal motion
-        for (size_t i = 1; i < segments.size(); ++i)
+        sf::Event event;
+        while (window.pollEvent(event))
         {
-            segments[i].angle = amplitude * std::sin(frequency * i - speed * deltaTime);
-            segments[i].position = segments[i - 1].position +
-                                   sf::Vector2f(std::cos(segments[i].angle), std::sin(segments[i].angle)) * segments[i].length;
+            if (event.type == sf::Event::Closed)
+                window.close();
         }
 
-        // IK: Move towards target
-        segments.back().position = target;
-        for (int i = segments.size() - 2; i >= 0; --i)
+        time += clock.restart().asSeconds();
+        moveTargets(batch, time, toVec2(sf::Vector2f(sf::Mouse::getPosition(window))), (joints - 1) * segmentLength);
+        batch.solve(threads);
+
+        renderer.begin();
+        for (int c = 0; c < chainCount; ++c)
         {
-            sf::Vector2f dir = segments[i + 1].position - segments[i].position;
-            float distance = std::hypot(dir.x, dir.y);
-            sf::Vector2f offset = (dir / distance) * segments[i].length;
-            segments[i].position = segments[i + 1].position - offset;
+            for (int j = 0; j < joints - 1; ++j)
+            {
+                renderer.line(sf::Vector2f(batch.x[j * chainCount + c], batch.y[j * chainCount + c]),
+                              sf::Vector2f(batch.x[(j + 1) * chainCount + c], batch.y[(j + 1) * chainCount + c]),
+                              sf::Color::White);
+            }
         }
+
+        window.clear();
+        renderer.flush(window);
+        window.display();
     }
 
-    void render(sf::RenderWindow &window)
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::strcmp(argv[1], "--tentacles") == 0)
     {
-        for (const auto &segment : segments)
-        {
-            sf::RectangleShape line(sf::Vector2f(segment.length, 5));
-            line.setPosition(segment.position);
-            line.setRotation(segment.angle * 180 / M_PI);
-            window.draw(line);
-        }
+        return runTentacles(argc > 2 ? std::atoi(argv[2]) : 200);
     }
-};
 
-int main()
-{
     sf::RenderWindow window(sf::VideoMode(800, 600), "Snake with FK and IK");
 
     Snake snake(10, 20.f);
     sf::Vector2f target(400, 300);
+    BatchRenderer renderer;
     sf::Clock clock;
 
     while (window.isOpen())
@@ -82,10 +96,13 @@ int main()
         target = sf::Vector2f(sf::Mouse::getPosition(window));
 
         float deltaTime = clock.restart().asSeconds();
-        snake.update(deltaTime, target);
+        snake.update(deltaTime, toVec2(target));
+
+        renderer.begin();
+        renderSnake(renderer, snake);
 
         window.clear();
-        snake.render(window);
+        renderer.flush(window);
         window.display();
     }
 
@@ -0,0 +1,86 @@
+#include "snake.hpp"
+
+// every chain's target circles around its own point near the mouse, with its own phase
+void moveTargets(ChainBatch &batch, float time, Vec2 focus, float reach)
+{
+    for (int c = 0; c < batch.chainCount; ++c)
+    {
+        float phase = c * 0.61803f * 2.0f * static_cast<float>(M_PI);
+        float cx = batch.rootX[c] + 0.5f * (focus.x - batch.rootX[c]);
+        float cy = batch.rootY[c] + 0.5f * (focus.y - batch.rootY[c]);
+        batch.targetX[c] = cx + 0.3f * reach * std::cos(time * 1.3f + phase);
+        batch.targetY[c] = cy + 0.3f * reach * std::sin(time * 1.7f + phase);
+    }
+}
+
+namespace
+{
+    struct SnakeMotion
+    {
+        float amplitude, frequency, speed;
+    };
+
+    struct ChainShape
+    {
+        int32_t chainCount, jointCount;
+        int32_t maxIterations, lastIterations;
+        float tolerance;
+    };
+}
+
+void saveSnake(SnapshotWriter &writer, const Snake &snake)
+{
+    writer.value("motion", SnakeMotion{snake.amplitude, snake.frequency, snake.speed});
+    writer.array("segments", snake.segments);
+}
+
+bool loadSnake(SnapshotReader &reader, Snake &snake)
+{
+    SnakeMotion motion;
+    if (!reader.value("motion", motion) || !reader.array("segments", snake.segments))
+        return false;
+    snake.amplitude = motion.amplitude;
+    snake.frequency = motion.frequency;
+    snake.speed = motion.speed;
+    return true;
+}
+
+void saveChains(SnapshotWriter &writer, const ChainBatch &batch)
+{
+    writer.value("chains", ChainShape{batch.chainCount, batch.jointCount, batch.maxIterations, batch.lastIterations,
+                                      batch.tolerance});
+    writer.array("x", batch.x);
+    writer.array("y", batch.y);
+    writer.array("lengths", batch.lengths);
+    writer.array("rootX", batch.rootX);
+    writer.array("rootY", batch.rootY);
+    writer.array("targetX", batch.targetX);
+    writer.array("targetY", batch.targetY);
+}
+
+bool loadChains(SnapshotReader &reader, ChainBatch &batch)
+{
+    ChainShape shape;
+    if (!reader.value("chains", shape))
+        return false;
+    reader.array("x", batch.x);
+    reader.array("y", batch.y);
+    reader.array("lengths", batch.lengths);
+    reader.array("rootX", batch.rootX);
+    reader.array("rootY", batch.rootY);
+    reader.array("targetX", batch.targetX);
+    reader.array("targetY", batch.targetY);
+
+    size_t joints = static_cast<size_t>(shape.chainCount) * shape.jointCount;
+    size_t chains = static_cast<size_t>(shape.chainCount);
+    if (!reader.ok() || batch.x.size() != joints || batch.y.size() != joints || batch.lengths.size() != joints - chains ||
+        batch.rootX.size() != chains || batch.rootY.size() != chains || batch.targetX.size() != chains || batch.targetY.size() != chains)
+        return false;
+
+    batch.chainCount = shape.chainCount;
+    batch.jointCount = shape.jointCount;
+    batch.maxIterations = shape.maxIterations;
+    batch.lastIterations = shape.lastIterations;
+    batch.tolerance = shape.tolerance;
+    return true;
+}
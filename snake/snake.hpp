@@ -0,0 +1,323 @@
+#pragma once
+
+#include "../common/parallel.hpp"
+#include "../common/snapshot.hpp"
+#include "../common/vec2.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// snake and FABRIK chain physics, no SFML in here so it can be used by the viewer, the headless runner and the benchmarks
+
+struct Segment
+{
+    Vec2 position;
+    float angle;
+    float length;
+
+    // Constructor
+    Segment(Vec2 pos, float ang, float len)
+        : position(pos), angle(ang), length(len) {}
+};
+
+class Snake
+{
+public:
+    std::vector<Segment> segments;
+    float amplitude = 20.f;
+    float frequency = 0.5f;
+    float speed = 100.f;
+
+    Snake(int numSegments, float segmentLength)
+    {
+        for (int i = 0; i < numSegments; ++i)
+        {
+            segments.emplace_back(Vec2(400, 300 - i * segmentLength), 0, segmentLength);
+        }
+    }
+
+    void update(float deltaTime, Vec2 target)
+    {
+        // FK: Sinusoidal motion
+        for (size_t i = 1; i < segments.size(); ++i)
+        {
+            segments[i].angle = amplitude * std::sin(frequency * i - speed * deltaTime);
+            segments[i].position = segments[i - 1].position +
+                                   Vec2(std::cos(segments[i].angle), std::sin(segments[i].angle)) * segments[i].length;
+        }
+
+        // IK: Move towards target
+        segments.back().position = target;
+        for (int i = segments.size() - 2; i >= 0; --i)
+        {
+            Vec2 dir = segments[i + 1].position - segments[i].position;
+            float distance = std::hypot(dir.x, dir.y);
+            Vec2 offset = (dir / distance) * segments[i].length;
+            segments[i].position = segments[i + 1].position - offset;
+        }
+    }
+};
+
+// many chains with the same number of joints, solved together with FABRIK
+// (Aristidou & Lasenby, "FABRIK: A fast, iterative solver for the Inverse Kinematics problem", 2011)
+//
+// the storage is SoA and joint-major: joint j of chain c is at x[j * chainCount + c].
+// every step of FABRIK does the same thing to joint j of every chain, so the inner loops run over consecutive chains
+// and the compiler can vectorize them across chains (build with -O3, and -fno-math-errno so sqrt vectorizes).
+// the joint count is a run time value on purpose: a copy of the solver per joint count (4, 8, 10, 16, 32) fixed at
+// compile time ran snake/fabrik no faster (6.6-6.8 ms either way for 10^5 chains of 10 joints), the loops over joints
+// are short next to the vectorized loops over 256 chains inside them
+class ChainBatch
+{
+public:
+    int chainCount;
+    int jointCount;
+    std::vector<float> x, y;             // joint positions
+    std::vector<float> lengths;          // segment s joins joint s and s + 1, lengths[s * chainCount + c]
+    std::vector<float> rootX, rootY;     // joint 0 is pinned here
+    std::vector<float> targetX, targetY; // the last joint tries to reach this
+
+    int maxIterations = 10;
+    float tolerance = 0.5f; // pixels between the end of the chain and its target
+    int lastIterations = 0; // iterations used by the slowest chain in the last solve
+    long long lastChainIterations = 0; // iterations summed over all chains in the last solve, the work actually done
+
+    // chains start out straight up from their roots
+    ChainBatch(int chainCount, int jointCount, float segmentLength)
+        : chainCount(chainCount), jointCount(jointCount),
+          x(chainCount * jointCount), y(chainCount * jointCount), lengths(chainCount * (jointCount - 1), segmentLength),
+          rootX(chainCount), rootY(chainCount), targetX(chainCount), targetY(chainCount) {}
+
+    void setRoot(int c, float px, float py)
+    {
+        rootX[c] = px;
+        rootY[c] = py;
+        for (int j = 0; j < jointCount; ++j)
+        {
+            x[j * chainCount + c] = px;
+            y[j * chainCount + c] = py - j * lengths[c];
+        }
+        targetX[c] = px;
+        targetY[c] = py - (jointCount - 1) * lengths[c];
+    }
+
+    // chains are handled in blocks that stay in L1. a chain stops iterating as soon as its end is within tolerance,
+    // and a chain whose target is out of reach is laid straight towards it in one pass instead, the closest it can get
+    void solve(int threadCount = 1)
+    {
+        const int blockCount = (chainCount + BLOCK - 1) / BLOCK;
+        std::vector<int> iterations(blockCount, 0);
+        std::vector<long long> chainIterations(blockCount, 0);
+
+        parallelFor(blockCount, threadCount, [&](int begin, int end)
+                    {
+                        BlockWork work;
+                        for (int b = begin; b < end; ++b)
+                            iterations[b] = solveBlock(b * BLOCK, std::min(chainCount, (b + 1) * BLOCK), work, chainIterations[b]);
+                    });
+
+        lastIterations = 0;
+        lastChainIterations = 0;
+        for (int b = 0; b < blockCount; ++b)
+        {
+            lastIterations = std::max(lastIterations, iterations[b]);
+            lastChainIterations += chainIterations[b];
+        }
+    }
+
+private:
+    static constexpr int BLOCK = 256;
+
+    // the last unfinished chains of a block, copied out of the batch with the same joint-major layout and a stride of BLOCK.
+    // they are kept packed in lanes [0, active), a chain that is done is written back and swapped with the last active
+    // lane, so every pass runs over consecutive lanes and only over the chains that need it
+    struct BlockWork
+    {
+        std::vector<float> x, y, lengths;
+        float rootX[BLOCK], rootY[BLOCK], targetX[BLOCK], targetY[BLOCK];
+        int chain[BLOCK]; // chain of the batch in every lane
+    };
+
+    // moves joint `to` onto the line towards joint `from` so that it sits `length` away from `from`
+    static void placeJoint(float *__restrict toX, float *__restrict toY,
+                           const float *__restrict fromX, const float *__restrict fromY,
+                           const float *__restrict length, int count)
+    {
+        for (int c = 0; c < count; ++c)
+        {
+            float dx = toX[c] - fromX[c];
+            float dy = toY[c] - fromY[c];
+            float dist = std::sqrt(dx * dx + dy * dy) + 1e-12f;
+            float scale = length[c] / dist;
+            toX[c] = fromX[c] + dx * scale;
+            toY[c] = fromY[c] + dy * scale;
+        }
+    }
+
+    // writes lane back to its chain and moves the last active lane into its place
+    void retireLane(BlockWork &work, int joints, int lane, int &active)
+    {
+        const int c = work.chain[lane];
+        const int last = --active;
+        for (int j = 0; j < joints; ++j)
+        {
+            x[j * chainCount + c] = work.x[j * BLOCK + lane];
+            y[j * chainCount + c] = work.y[j * BLOCK + lane];
+            work.x[j * BLOCK + lane] = work.x[j * BLOCK + last];
+            work.y[j * BLOCK + lane] = work.y[j * BLOCK + last];
+        }
+        for (int j = 0; j < joints - 1; ++j)
+            work.lengths[j * BLOCK + lane] = work.lengths[j * BLOCK + last];
+        work.rootX[lane] = work.rootX[last];
+        work.rootY[lane] = work.rootY[last];
+        work.targetX[lane] = work.targetX[last];
+        work.targetY[lane] = work.targetY[last];
+        work.chain[lane] = work.chain[last];
+    }
+
+    // one FABRIK iteration of count chains whose joint j is at x[j * stride], y[j * stride]
+    static void reachPass(float *px, float *py, const float *len, const float *baseX, const float *baseY,
+                          const float *goalX, const float *goalY, int joints, int stride, int count)
+    {
+        // forward reaching: put the end on the target and drag the chain after it towards the root
+        std::copy(goalX, goalX + count, px + (joints - 1) * stride);
+        std::copy(goalY, goalY + count, py + (joints - 1) * stride);
+        for (int j = joints - 2; j >= 0; --j)
+            placeJoint(px + j * stride, py + j * stride, px + (j + 1) * stride, py + (j + 1) * stride, len + j * stride, count);
+
+        // backward reaching: put the root back on its anchor and drag the chain after it towards the end
+        std::copy(baseX, baseX + count, px);
+        std::copy(baseY, baseY + count, py);
+        for (int j = 1; j < joints; ++j)
+            placeJoint(px + j * stride, py + j * stride, px + (j - 1) * stride, py + (j - 1) * stride, len + (j - 1) * stride, count);
+    }
+
+    // while most of the block still needs work it is iterated in place, finished chains included (for them an iteration
+    // only tightens the fit, and a straight chain pointing at an unreachable target does not move). once the unfinished
+    // chains are down to a quarter of the block they are copied into packed lanes and only they iterate on
+    int solveBlock(int c0, int c1, BlockWork &work, long long &chainIterations)
+    {
+        const int joints = jointCount;
+        const int count = c1 - c0;
+        const int stride = chainCount;
+        const float toleranceSq = tolerance * tolerance;
+
+        float *px = x.data() + c0;
+        float *py = y.data() + c0;
+        const float *len = lengths.data() + c0;
+        const float *baseX = rootX.data() + c0;
+        const float *baseY = rootY.data() + c0;
+        const float *goalX = targetX.data() + c0;
+        const float *goalY = targetY.data() + c0;
+
+        // reach test: a target further from the root than the chain is long cannot be reached, and FABRIK would only
+        // crawl towards the straight chain that is the answer, so it is laid straight along root -> target right away.
+        // the 0 / 1 weights blend instead of branching, so these loops vectorize like placeJoint
+        float along[BLOCK], dirX[BLOCK], dirY[BLOCK], far[BLOCK], done[BLOCK];
+        std::fill(along, along + count, 0.0f);
+        for (int j = 0; j < joints - 1; ++j)
+            for (int c = 0; c < count; ++c)
+                along[c] += len[j * stride + c];
+        for (int c = 0; c < count; ++c)
+        {
+            float dx = goalX[c] - baseX[c];
+            float dy = goalY[c] - baseY[c];
+            float dist = std::sqrt(dx * dx + dy * dy) + 1e-12f;
+            far[c] = dist > along[c] ? 1.0f : 0.0f;
+            dirX[c] = dx / dist;
+            dirY[c] = dy / dist;
+            along[c] = 0.0f;
+            px[c] += far[c] * (baseX[c] - px[c]);
+            py[c] += far[c] * (baseY[c] - py[c]);
+        }
+        for (int j = 1; j < joints; ++j)
+        {
+            for (int c = 0; c < count; ++c)
+            {
+                along[c] += len[(j - 1) * stride + c];
+                px[j * stride + c] += far[c] * (baseX[c] + dirX[c] * along[c] - px[j * stride + c]);
+                py[j * stride + c] += far[c] * (baseY[c] + dirY[c] * along[c] - py[j * stride + c]);
+            }
+        }
+
+        int iteration = 0;
+        int active = 0;
+        for (;; ++iteration)
+        {
+            // a chain is done when it was laid straight or its end is close enough
+            float unfinished = 0.0f;
+            const float *endX = px + (joints - 1) * stride;
+            const float *endY = py + (joints - 1) * stride;
+            for (int c = 0; c < count; ++c)
+            {
+                float dx = endX[c] - goalX[c];
+                float dy = endY[c] - goalY[c];
+                done[c] = std::max(far[c], dx * dx + dy * dy <= toleranceSq ? 1.0f : 0.0f);
+                unfinished += 1.0f - done[c];
+            }
+            active = static_cast<int>(unfinished);
+            if (iteration == maxIterations || active * 4 <= count)
+                break;
+            reachPass(px, py, len, baseX, baseY, goalX, goalY, joints, stride, count);
+            chainIterations += count;
+        }
+        if (active == 0 || iteration == maxIterations)
+            return iteration;
+
+        // pack the stragglers
+        work.x.resize(joints * BLOCK);
+        work.y.resize(joints * BLOCK);
+        work.lengths.resize((joints - 1) * BLOCK);
+        active = 0;
+        for (int c = 0; c < count; ++c)
+        {
+            if (done[c] > 0.0f)
+                continue;
+            const int lane = active++;
+            for (int j = 0; j < joints; ++j)
+            {
+                work.x[j * BLOCK + lane] = px[j * stride + c];
+                work.y[j * BLOCK + lane] = py[j * stride + c];
+            }
+            for (int j = 0; j < joints - 1; ++j)
+                work.lengths[j * BLOCK + lane] = len[j * stride + c];
+            work.rootX[lane] = baseX[c];
+            work.rootY[lane] = baseY[c];
+            work.targetX[lane] = goalX[c];
+            work.targetY[lane] = goalY[c];
+            work.chain[lane] = c0 + c;
+        }
+
+        while (active > 0 && iteration < maxIterations)
+        {
+            reachPass(work.x.data(), work.y.data(), work.lengths.data(), work.rootX, work.rootY,
+                      work.targetX, work.targetY, joints, BLOCK, active);
+            chainIterations += active;
+            ++iteration;
+
+            const float *endX = work.x.data() + (joints - 1) * BLOCK;
+            const float *endY = work.y.data() + (joints - 1) * BLOCK;
+            for (int lane = active - 1; lane >= 0; --lane)
+            {
+                float dx = endX[lane] - work.targetX[lane];
+                float dy = endY[lane] - work.targetY[lane];
+                if (dx * dx + dy * dy <= toleranceSq)
+                    retireLane(work, joints, lane, active);
+            }
+        }
+
+        // chains still out of tolerance after maxIterations keep the pose they got to
+        while (active > 0)
+            retireLane(work, joints, active - 1, active);
+        return iteration;
+    }
+};
+
+// every chain's target circles around its own point near focus, with its own phase
+void moveTargets(ChainBatch &batch, float time, Vec2 focus, float reach);
+
+// segments and motion parameters of a snake, every array of a chain batch
+void saveSnake(SnapshotWriter &writer, const Snake &snake);
+bool loadSnake(SnapshotReader &reader, Snake &snake);
+void saveChains(SnapshotWriter &writer, const ChainBatch &batch);
+bool loadChains(SnapshotReader &reader, ChainBatch &batch);
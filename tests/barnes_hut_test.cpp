@@ -0,0 +1,55 @@
+#include "../ball_in_box/barnes_hut.hpp"
+#include <cstdio>
+
+// coincident bodies end up lumped in one leaf at the tree's maximum depth, they must still all pull with their full
+// mass and all get an acceleration written
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what, int count)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s, %d coincident bodies\n", what, count);
+            failures++;
+        }
+    }
+
+    void coincident(int count)
+    {
+        // count bodies at the origin and one far body on the x axis
+        std::vector<float> x(count + 1, 0.0f), y(count + 1, 0.0f), mass(count + 1, 1.0f);
+        x[count] = 10.0f;
+
+        BarnesHutTree tree;
+        tree.build(x, y, mass);
+
+        // anything left at the sentinel was never written
+        std::vector<float> ax(count + 1, 777.0f), ay(count + 1, 777.0f);
+        tree.computeAccelerations(x, y, ax, ay, 1);
+
+        std::vector<float> directX(count + 1), directY(count + 1);
+        directAccelerations(x, y, mass, tree.gravity, tree.softening, 0, count + 1, directX, directY);
+
+        check(tree.order.size() == x.size(), "every body is in the order", count);
+        for (int i = 0; i <= count; ++i)
+        {
+            check(ax[i] != 777.0f && ay[i] != 777.0f, "every body gets an acceleration", count);
+            check(std::fabs(ax[i] - directX[i]) <= 1e-5f && std::fabs(ay[i] - directY[i]) <= 1e-5f, "matches the direct sum", count);
+        }
+        // a = G * count * dx / (dx^2 + eps^2)^(3/2) towards the origin
+        float expected = -count * 10.0f / std::pow(100.0f + 1.0f, 1.5f);
+        check(std::fabs(ax[count] - expected) <= 1e-5f, "the far body feels the whole lumped mass", count);
+    }
+}
+
+int main()
+{
+    for (int count : {2, 3, 4, 5, 40})
+        coincident(count);
+    if (failures == 0)
+        std::printf("barnes_hut_test: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+#include "../cloth_verlet/cloth.hpp"
+#include <cmath>
+#include <cstdio>
+
+// the same 300 x 300 px cloth split into 16, 31 and 61 particles a side must feel the same total wind force: every
+// row of cells has an edge facing a sideways wind, so unscaled the load would grow with the resolution
+
+namespace
+{
+    int failures = 0;
+
+    const float SIDE = 300.0f;
+
+    // total force on a flat, resting side x side cloth stretched to SIDE, nothing pinned so every particle gets its share
+    Vec2 totalForce(int side, Vec2 velocity)
+    {
+        std::vector<Particle> particles;
+        std::vector<Constraint> constraints;
+        buildCloth(particles, constraints, side, side);
+        Vec2 origin = particles.front().position;
+        float scale = SIDE / ((side - 1) * REST_DISTANCE);
+        for (auto &particle : particles)
+        {
+            particle.position = origin + (particle.position - origin) * scale;
+            particle.previousPosition = particle.position;
+            particle.isPinned = false;
+        }
+
+        ClothWind wind(side, side);
+        wind.velocity = velocity;
+        wind.apply(particles, constraints);
+
+        Vec2 total(0, 0);
+        for (const auto &particle : particles)
+            total = total + particle.acceleration;
+        return total;
+    }
+
+    void check(Vec2 velocity, const char *direction)
+    {
+        Vec2 reference = totalForce(31, velocity);
+        std::printf("%s wind: total force %g at 31 a side\n", direction, std::hypot(reference.x, reference.y));
+        if (!(std::hypot(reference.x, reference.y) > 0.0f))
+        {
+            std::printf("FAIL %s wind, no force at all\n", direction);
+            failures++;
+            return;
+        }
+        for (int side : {16, 61})
+        {
+            Vec2 force = totalForce(side, velocity);
+            float ratio = std::hypot(force.x, force.y) / std::hypot(reference.x, reference.y);
+            std::printf("%s wind: %d a side is %.4f times that\n", direction, side, ratio);
+            if (std::fabs(ratio - 1.0f) > 0.01f)
+            {
+                std::printf("FAIL %s wind, %d a side\n", direction, side);
+                failures++;
+            }
+        }
+    }
+}
+
+int main()
+{
+    check(Vec2(400, 0), "sideways");
+    check(Vec2(0, -400), "upward");
+    check(Vec2(300, 300), "diagonal");
+    if (failures == 0)
+        std::printf("cloth_wind_test: ok\n");
+    return failures == 0 ? 0 : 1;
+}
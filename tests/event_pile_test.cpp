@@ -0,0 +1,69 @@
+#include "../ball_in_box/ball.hpp"
+#include "../ball_in_box/event_sim.hpp"
+#include <cstdio>
+
+// the `headless pile` setup: 300 balls under gravity with restitution 0.8 settle on the floor. without the TC rule on
+// every collision the pile collapses inelastically and the event rate runs away (millions per 2 s by t = 10 s),
+// with it the rate stays bounded and the balls stay in the box without overlapping
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what, double t)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s at t = %g s\n", what, t);
+            failures++;
+        }
+    }
+}
+
+int main()
+{
+    const Box box(100, 100, 600, 400);
+    // positions come back as floats, a few ulps at 700 px
+    const double tolerance = 1e-2;
+    // 300 balls with a handful of contacts each, every one at most once per TC = 1e-2 s, is about 250000 per 2 s
+    const long long maxEventsPerWindow = 250000;
+
+    EventDrivenSimulation sim(box, 0.0, 980.0, 0.8);
+    scatterBalls(box, 300, 4.0f, 150.0f, 42, [&](float x, float y, float r, float vx, float vy)
+                 { sim.addBall(x, y, r, vx, vy); });
+    sim.initialize();
+    double startEnergy = sim.kineticEnergy();
+
+    for (double t = 2.0; t <= 10.0; t += 2.0)
+    {
+        long long startEvents = sim.eventCount;
+        sim.advanceTo(t);
+        long long events = sim.eventCount - startEvents;
+        std::printf("t = %2g s: %lld events\n", t, events);
+        check(events <= maxEventsPerWindow, "the event rate stays bounded", t);
+
+        int outside = 0, overlapping = 0;
+        for (size_t i = 0; i < sim.balls.size(); ++i)
+        {
+            Vec2 p = sim.positionAt(static_cast<int>(i), t);
+            double r = sim.balls[i].radius;
+            if (p.x < box.left + r - tolerance || p.x > box.left + box.width - r + tolerance ||
+                p.y < box.top + r - tolerance || p.y > box.top + box.height - r + tolerance)
+                outside++;
+            for (size_t j = i + 1; j < sim.balls.size(); ++j)
+            {
+                Vec2 q = sim.positionAt(static_cast<int>(j), t);
+                double sigma = r + sim.balls[j].radius;
+                if (std::hypot(p.x - q.x, p.y - q.y) < sigma - tolerance)
+                    overlapping++;
+            }
+        }
+        check(outside == 0, "every ball stays in the box", t);
+        check(overlapping == 0, "no two balls overlap", t);
+    }
+    check(sim.kineticEnergy() < startEnergy, "restitution 0.8 loses energy", 10.0);
+
+    if (failures == 0)
+        std::printf("event_pile_test: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include "../ball_in_box/ball.hpp"
+#include "../ball_in_box/event_sim.hpp"
+#include <cstddef>
+#include <cstdio>
+
+// an empty box must initialize (it used to size a grid of 1e-6 cells), and a snapshot whose ball or event indices
+// point outside the balls must be rejected by load() instead of crashing the resumed run
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            failures++;
+        }
+    }
+
+    // the bytes of the first record of section tag, snapshot sections are tag[8], uint64 elementSize, uint64 count, data
+    unsigned char *firstRecord(std::vector<unsigned char> &bytes, const char *tag)
+    {
+        for (size_t at = 16; at + 24 <= bytes.size();)
+        {
+            uint64_t sizes[2];
+            std::memcpy(sizes, &bytes[at + 8], sizeof(sizes));
+            if (std::strncmp(reinterpret_cast<const char *>(&bytes[at]), tag, 8) == 0)
+                return &bytes[at + 24];
+            at += 24 + ((sizes[0] * sizes[1] + 7) & ~uint64_t(7));
+        }
+        return nullptr;
+    }
+
+    // writes bytes with one int at offset in the first record of tag replaced, and loads it back
+    bool loadCorrupted(std::vector<unsigned char> bytes, const char *tag, size_t offset, int value)
+    {
+        unsigned char *record = firstRecord(bytes, tag);
+        if (record)
+            std::memcpy(record + offset, &value, sizeof(value));
+
+        const char *path = "event_snapshot_test.snap";
+        std::FILE *file = std::fopen(path, "wb");
+        if (!file)
+            return false;
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+
+        SnapshotReader reader;
+        EventDrivenSimulation sim(Box(0, 0, 1, 1));
+        bool loaded = reader.open(path) && sim.load(reader);
+        std::remove(path);
+        return loaded;
+    }
+}
+
+int main()
+{
+    const Box box(100, 100, 600, 400);
+
+    EventDrivenSimulation empty(box, 0.0, 980.0, 0.8);
+    empty.initialize();
+    empty.advanceTo(1.0);
+    check(empty.eventCount == 0, "an empty box has no events");
+
+    EventDrivenSimulation sim(box);
+    scatterBalls(box, 50, 4.0f, 150.0f, 42, [&](float x, float y, float r, float vx, float vy)
+                 { sim.addBall(x, y, r, vx, vy); });
+    sim.initialize();
+    sim.advanceTo(0.5);
+    SnapshotWriter writer;
+    sim.save(writer);
+    const std::vector<unsigned char> &bytes = writer.bytes();
+
+    int firstListed;
+    std::vector<unsigned char> copy = bytes;
+    std::memcpy(&firstListed, firstRecord(copy, "cellball"), sizeof(firstListed));
+    check(loadCorrupted(bytes, "cellball", 0, firstListed), "an intact snapshot loads");
+    check(!loadCorrupted(bytes, "cellball", 0, 50), "a cell listing a ball past the end is rejected");
+    check(!loadCorrupted(bytes, "cellball", 0, -1), "a cell listing a negative ball is rejected");
+    check(!loadCorrupted(bytes, "events", offsetof(CollisionEvent, a), 1000000), "an event for a ball past the end is rejected");
+    check(!loadCorrupted(bytes, "events", offsetof(CollisionEvent, a), -5), "an event for a negative ball is rejected");
+
+    if (failures == 0)
+        std::printf("event_snapshot_test: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+# a checkpoint continues bit for bit: SIMULATION run 400 steps straight and run 200 steps, then resumed from its
+# checkpoint for 200 more, must write identical checkpoints at step 400
+#
+# cmake -DHEADLESS=path/to/headless -DSIMULATION=cloth [-DCOUNT=64] -DWORK=scratch/dir -P resume_test.cmake
+
+set(count_args)
+if(COUNT)
+    set(count_args --count ${COUNT})
+endif()
+
+function(run)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "failed (${result}): ${ARGN}")
+    endif()
+endfunction()
+
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK}/straight ${WORK}/resumed)
+
+run(${HEADLESS} ${SIMULATION} ${count_args} --steps 400 --checkpoint 400 --out ${WORK}/straight)
+run(${HEADLESS} ${SIMULATION} ${count_args} --steps 200 --checkpoint 200 --out ${WORK}/resumed)
+run(${HEADLESS} resume ${WORK}/resumed/${SIMULATION}_00000200.snap --steps 400 --checkpoint 400 --out ${WORK}/resumed)
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                ${WORK}/straight/${SIMULATION}_00000400.snap ${WORK}/resumed/${SIMULATION}_00000400.snap
+                RESULT_VARIABLE different)
+if(NOT different EQUAL 0)
+    message(FATAL_ERROR "${SIMULATION}: the resumed run's checkpoint differs from the straight run's")
+endif()